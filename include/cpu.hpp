@@ -15,6 +15,7 @@
 */
 
 #pragma once
+#include "cpu_enrichment.hpp"
 #include "smbios_mdrv2.hpp"
 
 #include <xyz/openbmc_project/Association/Definitions/server.hpp>
@@ -332,6 +333,13 @@ class Cpu :
     void infoUpdate(uint8_t* smbiosTableStorage,
                     const std::string& motherboard);
 
+    /**
+     * Attach values from an enrichment provider.
+     *
+     * @param[in]   values  Values to attach.
+     */
+    void enrich(const CpuEnrichment& values);
+
   private:
     uint8_t cpuNum;
 
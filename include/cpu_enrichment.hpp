@@ -0,0 +1,90 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <sdbusplus/asio/connection.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace smbios
+{
+
+/**
+ * CPU details which aren't in the SMBIOS tables, attached to the Cpu objects
+ * by an enrichment provider. Fields which are not set are left alone.
+ */
+struct CpuEnrichment
+{
+    /** Asset.Model, e.g. the SSpec read from the PIROM. */
+    std::optional<std::string> model;
+
+    /** Take over all the fields which are set in other. */
+    void merge(const CpuEnrichment& other);
+};
+
+/**
+ * Publish enrichment values for a CPU. They are attached to its Cpu object
+ * right away if it exists, and again whenever it is recreated.
+ *
+ * @param[in]   cpuNum  0-based CPU index.
+ * @param[in]   values  Values to attach.
+ */
+using CpuEnrichmentPublisher =
+    std::function<void(uint8_t cpuNum, const CpuEnrichment& values)>;
+
+/**
+ * A module which runs inside smbiosmdrv2app and provides CPU details for the
+ * Cpu objects, so that they don't have to be set over D-Bus by another
+ * service. Providers run on the main D-Bus thread and must not block it for
+ * long.
+ */
+class CpuEnrichmentProvider
+{
+  public:
+    virtual ~CpuEnrichmentProvider() = default;
+
+    /**
+     * Called whenever the Cpu object of a socket is created or its SMBIOS
+     * data is updated. Values published earlier have already been attached.
+     *
+     * @param[in]   cpuNum  0-based CPU index.
+     */
+    virtual void cpuUpdated(uint8_t cpuNum) = 0;
+};
+
+/**
+ * Create the enrichment providers enabled at build time.
+ *
+ * @param[in,out]   io      I/O context to run asynchronous work on.
+ * @param[in,out]   conn    D-Bus connection.
+ * @param[in]       publish Callback to publish values with.
+ *
+ * @return  Providers, which may be empty.
+ */
+std::vector<std::unique_ptr<CpuEnrichmentProvider>> makeCpuEnrichmentProviders(
+    boost::asio::io_context& io,
+    const std::shared_ptr<sdbusplus::asio::connection>& conn,
+    const CpuEnrichmentPublisher& publish);
+
+} // namespace smbios
+} // namespace phosphor
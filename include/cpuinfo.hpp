@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include "cpuinfo_tasks.hpp"
+#include "pirom.hpp"
+
 #include <sdbusplus/asio/object_server.hpp>
 #include <sdbusplus/server/object.hpp>
 #include <xyz/openbmc_project/Inventory/Decorator/Asset/server.hpp>
@@ -30,7 +33,6 @@ static constexpr const char* cpuPath =
     "/xyz/openbmc_project/inventory/system/chassis/motherboard/cpu";
 
 static constexpr const int configCheckInterval = 10;
-static constexpr const int peciCheckInterval = 60;
 
 using UniqueIdentifier =
     sdbusplus::server::object_t<sdbusplus::server::xyz::openbmc_project::
@@ -46,6 +48,14 @@ struct CPUInfo
 
     void publishUUID(sdbusplus::bus_t& bus, const std::string& uuid)
     {
+        if (uuidInterface)
+        {
+            if (uuidInterface->uniqueIdentifier() != uuid)
+            {
+                uuidInterface->uniqueIdentifier(uuid);
+            }
+            return;
+        }
         uuidInterface.emplace(bus, (cpuPath + std::to_string(id - 1)).c_str(),
                               UniqueIdentifier::action::defer_emit);
         uuidInterface->uniqueIdentifier(uuid);
@@ -58,7 +68,15 @@ struct CPUInfo
     uint8_t peciAddr;
     uint8_t i2cBus;
     uint8_t i2cDevice;
-    std::string sSpec;
+    /** Last PIROM fields read, until a second read confirms them. */
+    std::optional<PiromInfo> pirom;
+    bool piromConfirmed = false;
+
+    /**
+     * Scope of the coroutines reading this CPU. It is cancelled, and replaced,
+     * whenever the host state changes or the CPU is reconfigured.
+     */
+    std::shared_ptr<TaskScope> tasks = std::make_shared<TaskScope>();
 };
 
 } // namespace cpu_info
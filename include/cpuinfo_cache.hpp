@@ -0,0 +1,141 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <peci.h>
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace cpu_info
+{
+namespace cache
+{
+
+/**
+ * Default directory holding the per-socket cache files. Each socket has one
+ * JSON file, with one section per cpuinfo feature.
+ */
+static constexpr const char* defaultCacheDir = "/var/lib/cpuinfo";
+
+/**
+ * Change the directory holding the cache files, e.g. to a temporary directory
+ * in tests. Files in the previous directory are left as they are.
+ *
+ * @param[in]   dir     New cache directory.
+ */
+void setCacheDir(std::filesystem::path dir);
+
+/**
+ * Values which identify the physical CPU in a socket. CPUID and stepping alone
+ * can't tell two parts of the same SKU apart, so PPIN is included as well.
+ */
+struct CPUIdentity
+{
+    CPUModel model;
+    uint8_t stepping;
+    /** 0 if the CPU doesn't support PPIN. */
+    uint64_t ppin;
+
+    bool operator==(const CPUIdentity&) const = default;
+};
+
+void to_json(nlohmann::json& j, const CPUIdentity& identity);
+void from_json(const nlohmann::json& j, CPUIdentity& identity);
+
+/**
+ * Read the PPIN of a CPU over PECI.
+ *
+ * @param[in]   address PECI address of the CPU.
+ * @param[in]   model   CPU model, as returned by GetCPUID.
+ *
+ * @return  PPIN, or 0 if the CPU doesn't support it. nullopt if either half
+ *          of it couldn't be read, e.g. because the CPU is asleep or BIOS
+ *          hasn't enabled PPIN yet.
+ */
+std::optional<uint64_t> readPPIN(uint8_t address, CPUModel model);
+
+/**
+ * Read the identity of a CPU over PECI. This costs one GetCPUID and two
+ * RdPkgConfig commands.
+ *
+ * @param[in]   address PECI address of the CPU.
+ *
+ * @return  CPU identity, or nullopt if the CPU didn't respond to GetCPUID or
+ *          its PPIN couldn't be read.
+ */
+std::optional<CPUIdentity> readIdentity(uint8_t address);
+
+/**
+ * Load one section of a socket's cache file.
+ *
+ * @param[in]   address PECI address of the socket.
+ * @param[in]   section Name of the section.
+ *
+ * @return  Content of the section, or nullopt if it doesn't exist or the file
+ *          couldn't be parsed.
+ */
+std::optional<nlohmann::json> load(uint8_t address, std::string_view section);
+
+/**
+ * Replace one section of a socket's cache file, leaving the other sections
+ * untouched. The file is replaced atomically. Failures are logged, but
+ * otherwise ignored since the cache is only an optimization.
+ *
+ * @param[in]   address PECI address of the socket.
+ * @param[in]   section Name of the section.
+ * @param[in]   value   New content of the section.
+ */
+void store(uint8_t address, std::string_view section,
+           const nlohmann::json& value);
+
+/**
+ * Remove one section of a socket's cache file, leaving the other sections
+ * untouched. Failures are logged, but otherwise ignored.
+ *
+ * @param[in]   address PECI address of the socket.
+ * @param[in]   section Name of the section.
+ */
+void erase(uint8_t address, std::string_view section);
+
+/**
+ * Load the PPIN cached for a socket, i.e. the PPIN of the CPU which
+ * verifyPPIN last found in it.
+ *
+ * @param[in]   address PECI address of the socket.
+ *
+ * @return  Cached PPIN, or nullopt if there is none.
+ */
+std::optional<uint64_t> loadPPIN(uint8_t address);
+
+/**
+ * Read the identity of the CPU in a socket, and bring the PPIN cache in line
+ * with it. The cached entry is replaced if the CPUID, stepping or PPIN
+ * differ, and removed if the CPU reports no PPIN, since the cached one then
+ * can't be confirmed.
+ *
+ * @param[in]   address PECI address of the socket.
+ *
+ * @return  PPIN of the CPU, or 0 if it reports none. nullopt if its identity
+ *          couldn't be read, in which case the cache is left as it is.
+ */
+std::optional<uint64_t> verifyPPIN(uint8_t address);
+
+} // namespace cache
+} // namespace cpu_info
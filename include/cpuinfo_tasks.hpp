@@ -0,0 +1,252 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <sdbusplus/asio/connection.hpp>
+
+#include <chrono>
+#include <exception>
+#include <list>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace cpu_info
+{
+
+/**
+ * Cancellation scope for a group of coroutines which belong together, e.g. the
+ * work for one CPU in the current host power cycle. The coroutines hold a
+ * shared_ptr to their scope. Once it is cancelled, sleeps and resource waits
+ * in the scope end right away, and everything else stops at its next
+ * throwIfCancelled(). Either way, the coroutine ends with an operation_aborted
+ * boost::system::system_error.
+ *
+ * Only to be used on the io_context.
+ */
+class TaskScope
+{
+  public:
+    TaskScope() = default;
+    TaskScope(const TaskScope&) = delete;
+    TaskScope& operator=(const TaskScope&) = delete;
+
+    /** Cancel all coroutines in the scope. */
+    void cancel();
+
+    bool cancelled() const
+    {
+        return isCancelled;
+    }
+
+    /**
+     * For use after operations which can't be cancelled, e.g. D-Bus calls.
+     *
+     * @throw boost::system::system_error   operation_aborted if the scope was
+     *                                      cancelled.
+     */
+    void throwIfCancelled() const;
+
+    /**
+     * Sleep for a while.
+     *
+     * @throw boost::system::system_error   operation_aborted if the scope is
+     *                                      cancelled.
+     */
+    boost::asio::awaitable<void>
+        sleep(std::chrono::steady_clock::duration duration);
+
+    /**
+     * Wait for a timer to expire or be cancelled. The timer is cancelled along
+     * with the scope.
+     *
+     * @throw boost::system::system_error   operation_aborted if the scope is
+     *                                      cancelled.
+     */
+    boost::asio::awaitable<void> wait(boost::asio::steady_timer& timer);
+
+  private:
+    bool isCancelled = false;
+    /** Timers which coroutines in the scope are waiting for. */
+    std::list<boost::asio::steady_timer*> timers;
+};
+
+/**
+ * Bounds how many coroutines use a resource, e.g. a bus, at the same time.
+ * Waiters get the resource in FIFO order.
+ *
+ * Only to be used on the io_context.
+ */
+class ResourceLimiter
+{
+  public:
+    explicit ResourceLimiter(unsigned int limit) : limit(limit) {}
+    ResourceLimiter(const ResourceLimiter&) = delete;
+    ResourceLimiter& operator=(const ResourceLimiter&) = delete;
+
+    /** Permission to use the resource, which is returned when destroyed. */
+    class Permit
+    {
+      public:
+        Permit() = default;
+        explicit Permit(ResourceLimiter& limiter) : limiter(&limiter) {}
+        Permit(Permit&& other) noexcept :
+            limiter(std::exchange(other.limiter, nullptr))
+        {}
+        Permit& operator=(Permit&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                limiter = std::exchange(other.limiter, nullptr);
+            }
+            return *this;
+        }
+        ~Permit()
+        {
+            reset();
+        }
+
+        /** Return the resource early. */
+        void reset()
+        {
+            if (limiter != nullptr)
+            {
+                std::exchange(limiter, nullptr)->release();
+            }
+        }
+
+      private:
+        ResourceLimiter* limiter = nullptr;
+    };
+
+    /**
+     * Wait until the resource may be used.
+     *
+     * @param[in]   scope   Scope of the waiting coroutine.
+     *
+     * @throw boost::system::system_error   operation_aborted if the scope is
+     *                                      cancelled while waiting.
+     */
+    boost::asio::awaitable<Permit> acquire(std::shared_ptr<TaskScope> scope);
+
+  private:
+    struct Waiter
+    {
+        explicit Waiter(const boost::asio::any_io_executor& executor) :
+            timer(executor, boost::asio::steady_timer::time_point::max())
+        {}
+
+        boost::asio::steady_timer timer;
+        bool granted = false;
+    };
+
+    unsigned int limit;
+    unsigned int inUse = 0;
+    std::list<std::shared_ptr<Waiter>> waiters;
+
+    void release();
+};
+
+/**
+ * Start a coroutine on the io_context. It may end with an operation_aborted
+ * exception when its scope is cancelled; any other exception is logged.
+ *
+ * @param[in,out]   io      I/O context to run on.
+ * @param[in]       task    Coroutine to run.
+ * @param[in]       name    Name for log messages.
+ */
+void spawnTask(boost::asio::io_context& io, boost::asio::awaitable<void> task,
+               std::string name);
+
+/** Thread pool for blocking calls other than PECI, e.g. I2C transfers. */
+boost::asio::thread_pool& blockingPool();
+
+/**
+ * Run a blocking call on the blocking pool, and resume the coroutine on its
+ * own executor once it returns. The result must be default-constructible.
+ */
+template <typename Fn>
+auto runBlocking(Fn fn) -> boost::asio::awaitable<std::invoke_result_t<Fn&>>
+{
+    using Result = std::invoke_result_t<Fn&>;
+    auto initiation = [](auto handler, Fn fn) {
+        auto work = boost::asio::make_work_guard(
+            boost::asio::get_associated_executor(handler));
+        auto call = [handler = std::move(handler), fn = std::move(fn),
+                     work = std::move(work)]() mutable {
+            std::exception_ptr error;
+            Result result{};
+            try
+            {
+                result = fn();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            auto executor = work.get_executor();
+            boost::asio::post(executor,
+                              [handler = std::move(handler), error,
+                               result = std::move(result),
+                               work = std::move(work)]() mutable {
+                                  std::move(handler)(error, std::move(result));
+                              });
+        };
+        boost::asio::post(blockingPool(), std::move(call));
+    };
+    co_return co_await boost::asio::async_initiate<
+        const boost::asio::use_awaitable_t<>,
+        void(std::exception_ptr, Result)>(
+        std::move(initiation), boost::asio::use_awaitable, std::move(fn));
+}
+
+/**
+ * Call a D-Bus method and return its result.
+ *
+ * @throw boost::system::system_error   The call failed.
+ */
+template <typename Result, typename... Args>
+boost::asio::awaitable<Result>
+    methodCall(std::shared_ptr<sdbusplus::asio::connection> conn,
+               std::string service, std::string path, std::string interface,
+               std::string method, Args... args)
+{
+    co_return co_await boost::asio::async_initiate<
+        const boost::asio::use_awaitable_t<>,
+        void(boost::system::error_code, Result)>(
+        [&](auto handler) {
+            auto shared =
+                std::make_shared<decltype(handler)>(std::move(handler));
+            conn->async_method_call(
+                [shared](boost::system::error_code ec, const Result& result) {
+                    std::move (*shared)(ec, result);
+                },
+                service, path, interface, method, args...);
+        },
+        boost::asio::use_awaitable);
+}
+
+} // namespace cpu_info
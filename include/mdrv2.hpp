@@ -132,6 +132,11 @@ class MDRV2 :
 
         smbiosDir.dir[smbiosDirIndex].dataStorage = smbiosTableStorage;
 
+        enrichmentProviders = makeCpuEnrichmentProviders(
+            *io, bus, [this](uint8_t cpuNum, const CpuEnrichment& values) {
+                enrichCpu(cpuNum, values);
+            });
+
         agentSynchronizeData();
 
         smbiosInterface->register_method("GetRecordType", [this](size_t type) {
@@ -189,6 +194,15 @@ class MDRV2 :
     std::optional<size_t> getTotalDimmSlot(void);
     std::optional<size_t> getTotalPcieSlot(void);
     std::vector<std::unique_ptr<Cpu>> cpus;
+
+    /**
+     * Values published by the enrichment providers for each CPU, kept so that
+     * they can be attached again when the Cpu objects are recreated.
+     */
+    boost::container::flat_map<uint8_t, CpuEnrichment> cpuEnrichment;
+    std::vector<std::unique_ptr<CpuEnrichmentProvider>> enrichmentProviders;
+    void enrichCpu(uint8_t cpuNum, const CpuEnrichment& values);
+
     std::vector<std::unique_ptr<Dimm>> dimms;
     std::vector<std::unique_ptr<Pcie>> pcies;
     std::unique_ptr<System> system;
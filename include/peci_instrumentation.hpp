@@ -0,0 +1,109 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <peci.h>
+
+#include <sdbusplus/asio/object_server.hpp>
+
+#include <chrono>
+#include <cstdint>
+
+namespace cpu_info
+{
+namespace peci
+{
+
+/**
+ * Instrumented wrappers for the libpeci calls made by cpuinfoapp. They take
+ * the same parameters as the libpeci functions of the same name, and record
+ * the call count, latency, driver status and completion code of every call.
+ *
+ * Recording only touches relaxed atomic counters, so these may be called from
+ * any thread with negligible overhead. The counters are only aggregated when
+ * read over D-Bus.
+ */
+EPECIStatus getCPUID(uint8_t target, CPUModel* cpuModel, uint8_t* stepping,
+                     uint8_t* cc);
+EPECIStatus rdPkgConfig(uint8_t target, uint8_t index, uint16_t param,
+                        uint8_t readLen, uint8_t* data, uint8_t* cc);
+EPECIStatus wrPkgConfig(uint8_t target, uint8_t index, uint16_t param,
+                        uint32_t value, uint8_t writeLen, uint8_t* cc);
+EPECIStatus rdIAMSR(uint8_t target, uint8_t threadID, uint16_t msrAddress,
+                    uint64_t* value, uint8_t* cc);
+EPECIStatus rdEndPointConfigPciLocal(uint8_t target, uint8_t seg, uint8_t bus,
+                                     uint8_t device, uint8_t fcn, uint16_t reg,
+                                     uint8_t readLen, uint8_t* data,
+                                     uint8_t* cc);
+EPECIStatus wrEndPointPCIConfigLocal(uint8_t target, uint8_t seg, uint8_t bus,
+                                     uint8_t device, uint8_t fcn, uint16_t reg,
+                                     uint8_t dataLen, uint32_t value,
+                                     uint8_t* cc);
+EPECIStatus rdEndPointConfigMmio(uint8_t target, uint8_t seg, uint8_t bus,
+                                 uint8_t device, uint8_t fcn, uint8_t bar,
+                                 uint8_t addrType, uint64_t offset,
+                                 uint8_t readLen, uint8_t* data, uint8_t* cc);
+
+/**
+ * Record that Wake-On-PECI was set or cleared on a CPU.
+ *
+ * @param[in]   enable  Whether the bit was set or cleared.
+ */
+void recordWakeOnPECI(bool enable);
+
+/**
+ * Record a completed OS Mailbox command.
+ *
+ * @param[in]   subCommand  Sub command ID.
+ * @param[in]   polls       Number of RUN_BUSY polls the command needed.
+ * @param[in]   duration    Time from starting the command to its response.
+ */
+void recordMailboxCommand(uint8_t subCommand, unsigned int polls,
+                          std::chrono::microseconds duration);
+
+/** Reasons for repeating PECI work, counted by recordRetry. */
+enum class Retry
+{
+    /** A CPU didn't answer a readiness probe, so it is probed again later. */
+    readinessProbe,
+    /** A consumer's commands failed, so it waits for the CPU to respond. */
+    retryWhenReady,
+    /** An OS Mailbox poll found RUN_BUSY still set. */
+    mailboxBusy,
+    /** A sleeping CPU rejected a command, which is resent after waking it. */
+    wakeOnPECI,
+    count
+};
+
+/**
+ * Record that PECI work is repeated.
+ *
+ * @param[in]   retry   Reason for the retry.
+ */
+void recordRetry(Retry retry);
+
+/**
+ * Publish the PECI metrics on the xyz.openbmc_project.CPUInfo.PECIMetrics
+ * interface of the CPUInfo object. Like xyz.openbmc_project.CPUInfo itself,
+ * the interface is specific to cpuinfoapp, and not defined in
+ * phosphor-dbus-interfaces. The property values are computed when read, so
+ * they never emit PropertiesChanged.
+ *
+ * @param[in,out]   objServer   Object server to add the interface to.
+ */
+void initMetrics(sdbusplus::asio::object_server& objServer);
+
+} // namespace peci
+} // namespace cpu_info
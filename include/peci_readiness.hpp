@@ -0,0 +1,80 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace cpu_info
+{
+namespace peci
+{
+
+/**
+ * A CPU which isn't responding is probed with GetCPUID, first after
+ * readinessProbeMin and then backing off up to readinessProbeMax between
+ * probes. The backoff starts over once a consumer reports that its own
+ * commands succeeded, and whenever the host completes POST. A CPU answering
+ * GetCPUID alone doesn't reset it, since it does so long before e.g. its OS
+ * Mailbox works.
+ */
+static constexpr std::chrono::milliseconds readinessProbeMin{250};
+static constexpr std::chrono::milliseconds readinessProbeMax{10000};
+
+/**
+ * Called on the io_context once a CPU has answered a probe.
+ *
+ * @param[in]   present     False if PECI reported that the socket is empty.
+ */
+using ReadyHandler = std::function<void(bool present)>;
+
+/**
+ * Call a handler as soon as a CPU responds to PECI. If it already did in the
+ * current power cycle, the handler is called right away (but not from within
+ * this call). Handlers which are still waiting when the host powers off are
+ * dropped, since their work needs to start over anyway.
+ *
+ * @param[in]   address PECI address of the CPU.
+ * @param[in]   handler Handler to call.
+ */
+void whenReady(uint8_t address, ReadyHandler handler);
+
+/**
+ * Like whenReady, but for a consumer whose PECI commands just failed even
+ * though the CPU responded earlier. The CPU is probed again, after a delay
+ * which grows with every retry until confirmReady is called.
+ *
+ * @param[in]   address PECI address of the CPU.
+ * @param[in]   handler Handler to call.
+ */
+void retryWhenReady(uint8_t address, ReadyHandler handler);
+
+/**
+ * Report that a consumer's PECI commands succeeded on a CPU, so the next
+ * retryWhenReady on it starts over at the shortest delay.
+ *
+ * @param[in]   address PECI address of the CPU.
+ */
+void confirmReady(uint8_t address);
+
+/**
+ * Start tracking the host state, which resets readiness on power-off and
+ * triggers probes when POST completes.
+ */
+void initReadiness();
+
+} // namespace peci
+} // namespace cpu_info
@@ -0,0 +1,217 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace cpu_info
+{
+namespace peci
+{
+
+/**
+ * Number of PECI requests which may run at the same time. The bus itself
+ * serializes transactions, but requests to different CPUs can still overlap
+ * the time each CPU spends processing a command (e.g. OS mailbox RUN_BUSY).
+ * All PECI work in cpuinfoapp goes through the worker, so this is the one
+ * limit on concurrent use of the PECI bus.
+ */
+static constexpr unsigned int workerThreads = 4;
+
+/**
+ * Executor for blocking PECI transactions.
+ *
+ * libpeci calls block until the transaction completes, which can take a long
+ * time when the bus is contended or a CPU is slow to respond. Running them on
+ * dedicated threads keeps the io_context (and therefore D-Bus handling) free.
+ *
+ * Requests are started in FIFO order, and up to the given number of requests
+ * run concurrently. Callers are responsible for serializing any multi-command
+ * sequences which must not interleave on a single CPU. Results are delivered
+ * back through an ASIO completion token with the signature
+ * void(std::exception_ptr, Result), or void(std::exception_ptr) if the request
+ * returns nothing. The completion handler always runs on its associated
+ * executor (the io_context by default), so it's safe to touch D-Bus objects
+ * from there. Both plain callbacks and boost::asio::use_awaitable may be used
+ * as the token.
+ */
+class Worker
+{
+  public:
+    Worker(boost::asio::io_context& ioc, unsigned int threadCount);
+    ~Worker();
+
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+    Worker(Worker&&) = delete;
+    Worker& operator=(Worker&&) = delete;
+
+    /**
+     * Queue a request to run on a worker thread.
+     *
+     * @param[in]   fn      Callable run on a worker thread. It may optionally
+     *                      take a std::stop_token, which is signalled when the
+     *                      request is cancelled, so that long requests can bail
+     *                      out early. Any exception it throws is passed to the
+     *                      completion handler. Non-void results must be
+     *                      default-constructible.
+     * @param[in]   token   ASIO completion token.
+     */
+    template <typename Fn, typename CompletionToken>
+    auto post(Fn&& fn, CompletionToken&& token)
+    {
+        using Result = decltype(invoke(fn, std::stop_token()));
+        using Signature = typename CompletionSignature<Result>::type;
+
+        return boost::asio::async_initiate<CompletionToken, Signature>(
+            [this](auto handler, auto fn) {
+                auto work = boost::asio::make_work_guard(
+                    boost::asio::get_associated_executor(handler,
+                                                         ioc.get_executor()));
+                enqueue([handler = std::move(handler), fn = std::move(fn),
+                         work = std::move(work)](std::stop_token stop) mutable {
+                    complete<Result>(std::move(handler), std::move(fn),
+                                     std::move(work), std::move(stop));
+                });
+            },
+            token, std::forward<Fn>(fn));
+    }
+
+    /**
+     * Cancel all outstanding requests. Queued requests are not run, and
+     * requests which are already running have their stop_token signalled.
+     * Either way, their handlers complete with an operation_aborted
+     * boost::system::system_error.
+     */
+    void cancelAll();
+
+  private:
+    using Job = std::move_only_function<void(std::stop_token)>;
+
+    template <typename Result>
+    struct CompletionSignature
+    {
+        using type = void(std::exception_ptr, Result);
+    };
+
+    struct QueuedJob
+    {
+        Job job;
+        std::stop_token stop;
+    };
+
+    template <typename Fn>
+    static decltype(auto) invoke(Fn& fn, std::stop_token stop)
+    {
+        if constexpr (std::is_invocable_v<Fn&, std::stop_token>)
+        {
+            return fn(std::move(stop));
+        }
+        else
+        {
+            return fn();
+        }
+    }
+
+    template <typename Result, typename Handler, typename Fn, typename Work>
+    static void complete(Handler handler, Fn fn, Work work,
+                         std::stop_token stop)
+    {
+        std::exception_ptr error;
+        std::conditional_t<std::is_void_v<Result>, std::monostate, Result>
+            result{};
+
+        if (!stop.stop_requested())
+        {
+            try
+            {
+                if constexpr (std::is_void_v<Result>)
+                {
+                    invoke(fn, stop);
+                }
+                else
+                {
+                    result = invoke(fn, stop);
+                }
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+        }
+        if (stop.stop_requested())
+        {
+            error = std::make_exception_ptr(boost::system::system_error(
+                boost::asio::error::operation_aborted));
+        }
+
+        auto executor = work.get_executor();
+        boost::asio::post(executor, [handler = std::move(handler), error,
+                                     result = std::move(result),
+                                     work = std::move(work)]() mutable {
+            if constexpr (std::is_void_v<Result>)
+            {
+                std::move(handler)(error);
+            }
+            else
+            {
+                std::move(handler)(error, std::move(result));
+            }
+        });
+    }
+
+    void enqueue(Job job);
+    void run();
+
+    boost::asio::io_context& ioc;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<QueuedJob> queue;
+    std::stop_source stopSource;
+    bool stopping = false;
+
+    std::vector<std::thread> threads;
+};
+
+template <>
+struct Worker::CompletionSignature<void>
+{
+    using type = void(std::exception_ptr);
+};
+
+/** Return the PECI worker shared by everything in cpuinfoapp. */
+Worker& getWorker();
+
+} // namespace peci
+} // namespace cpu_info
@@ -0,0 +1,89 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cpu_info
+{
+
+// constants for reading SSPEC or QDF string from PIROM
+// Currently, they are the same for platforms with Ice Lake
+static constexpr uint8_t defaultI2cBus = 13;
+static constexpr uint8_t defaultI2cSlaveAddr0 = 0x50;
+static constexpr uint8_t sspecRegAddr = 0xd;
+static constexpr uint8_t sspecSize = 6;
+
+// SSpec PIROM read retries back off exponentially between these bounds, and
+// give up on a CPU after sspecMaxFailedReads consecutive failures.
+static constexpr const std::chrono::seconds sspecRetryMin{1};
+static constexpr const std::chrono::seconds sspecRetryMax{60};
+static constexpr const unsigned int sspecMaxFailedReads = 10;
+
+/**
+ * Read a contiguous block of PIROM bytes. Prefer a single combined I2C
+ * transfer (write register offset, repeated start, read block), then an SMBus
+ * I2C-block read, and only fall back to one SMBus transaction per byte if the
+ * adapter supports neither.
+ *
+ * @param[in]   bus         I2C bus number.
+ * @param[in]   slaveAddr   7-bit I2C address of the PIROM.
+ * @param[in]   regAddr     Offset of the first byte to read.
+ * @param[in]   count       Number of bytes to read.
+ *
+ * @return  Bytes read, or nullopt on any failure.
+ */
+std::optional<std::vector<uint8_t>>
+    readPiromBlock(uint8_t bus, uint8_t slaveAddr, uint8_t regAddr,
+                   size_t count);
+
+/**
+ * Fields decoded from a PIROM. Only the SSpec is decoded so far; other fields
+ * can be added here and read by readPirom.
+ */
+struct PiromInfo
+{
+    /** SSpec, or QDF code for pre-production parts. */
+    std::string sSpec;
+
+    bool operator==(const PiromInfo&) const = default;
+};
+
+/**
+ * Read and decode the fields of a CPU's PIROM. Only the bytes of the decoded
+ * fields are read, each field in one block transfer as far as the adapter
+ * supports it.
+ *
+ * @param[in]   bus         I2C bus number.
+ * @param[in]   slaveAddr   7-bit I2C address of the PIROM.
+ *
+ * @return  Decoded fields, or nullopt if the read failed or the data is
+ *          implausible.
+ */
+std::optional<PiromInfo> readPirom(uint8_t bus, uint8_t slaveAddr);
+
+/**
+ * Delay before the next SSpec read attempt after the given number of
+ * consecutive failures. Doubles with each failure up to sspecRetryMax, with
+ * +/-25% jitter so that CPUs sharing a bus don't retry in lockstep.
+ */
+std::chrono::milliseconds sspecRetryDelay(unsigned int failedReads);
+
+} // namespace cpu_info
@@ -16,10 +16,16 @@
 #include <peci.h>
 
 #include <boost/asio/io_context.hpp>
+#include <boost/container/flat_map.hpp>
 #include <sdbusplus/asio/connection.hpp>
+#include <sdbusplus/asio/object_server.hpp>
 
-#include <bitset>
+#include <bit>
+#include <concepts>
 #include <iostream>
+#include <limits>
+#include <ranges>
+#include <vector>
 
 namespace cpu_info
 {
@@ -31,34 +37,117 @@ namespace sst
  *
  * This will schedule work to be done when the host is ready, in order to
  * retrieve all SST configuration info for all discoverable CPUs, and publish
- * the info on new D-Bus objects on the given bus connection.
+ * the info on new D-Bus objects on the given bus connection. It also adds the
+ * interface for applying configs to several CPUs at once.
+ *
+ * @param[in,out]   objServer   Object server to add the SST interface to.
  */
-void init();
+void init(sdbusplus::asio::object_server& objServer);
 
 class PECIError : public std::runtime_error
 {
     using std::runtime_error::runtime_error;
 };
 
+/**
+ * Thrown instead of PECIError when a command failed only because the package
+ * is in a low-power state, and the WakePolicy didn't allow waking it. This is
+ * expected for background reads of an idle CPU.
+ */
+class PECISleepingError : public PECIError
+{
+    using PECIError::PECIError;
+};
+
 bool checkPECIStatus(EPECIStatus libStatus, uint8_t completionCode);
 
+/**
+ * Whether a PECI command was rejected because the package is in a low-power
+ * state, and would succeed after setting Wake-On-PECI.
+ */
+bool isSleeping(EPECIStatus libStatus, uint8_t completionCode);
+
 constexpr int extendedModel(CPUModel model)
 {
     return (model >> 16) & 0xF;
 }
 
 /**
- * Construct a list of indexes of the set bits in the input value.
- * E.g. fn(0x7A) -> {1,3,4,5,6}
+ * Construct a list of indexes of the set bits in a bitmask of any width, given
+ * as a sequence of words starting with the least significant one.
+ * E.g. fn(std::vector<uint8_t>{0x7A, 0x01}) -> {1,3,4,5,6,8}
  *
  * @param[in]   mask    Bitmask to convert.
  *
  * @return  List of bit indexes.
  */
-std::vector<uint32_t> convertMaskToList(std::bitset<64> mask);
+template <std::ranges::input_range Words>
+    requires std::unsigned_integral<std::ranges::range_value_t<Words>>
+std::vector<unsigned int> convertMaskToList(const Words& mask)
+{
+    using Word = std::ranges::range_value_t<Words>;
+    constexpr unsigned int wordBits = std::numeric_limits<Word>::digits;
+
+    size_t count = 0;
+    for (Word word : mask)
+    {
+        count += std::popcount(word);
+    }
+
+    std::vector<unsigned int> bitList;
+    bitList.reserve(count);
+    unsigned int base = 0;
+    for (Word word : mask)
+    {
+        for (; word != 0; word &= word - 1)
+        {
+            bitList.push_back(base + std::countr_zero(word));
+        }
+        base += wordBits;
+    }
+    return bitList;
+}
 
 using TurboEntry = std::tuple<uint32_t, size_t>;
 
+/**
+ * Cache of package-scope register values, i.e. registers which read the same
+ * on every thread and don't change between SST-PP levels. Backends can use it
+ * to read such a register once per SSTInterface instance (once per CPU in a
+ * discovery pass) rather than once per level.
+ */
+class PackageRegisterCache
+{
+  public:
+    /**
+     * Return the value of a register, reading it only if it isn't cached yet.
+     *
+     * @param[in]   key     Backend-defined register identifier, e.g. the MSR
+     *                      address.
+     * @param[in]   read    Callable returning the register value. If it
+     *                      throws, nothing is cached.
+     */
+    template <typename ReadFn>
+    uint64_t get(uint32_t key, ReadFn&& read)
+    {
+        auto it = values.find(key);
+        if (it == values.end())
+        {
+            it = values.emplace(key, read()).first;
+        }
+        return it->second;
+    }
+
+    /** Drop all cached values. */
+    void clear()
+    {
+        values.clear();
+    }
+
+  private:
+    boost::container::flat_map<uint32_t, uint64_t> values;
+};
+
 /**
  * Abstract interface that must be implemented by backends, allowing discovery
  * and control of a single CPU package.
@@ -80,6 +169,14 @@ class SSTInterface
 
     /** Whether SST-PP is enabled on the processor. */
     virtual bool ppEnabled() = 0;
+    /**
+     * Whether the BIOS locked the SST-PP configuration, so that the level
+     * can't be changed.
+     */
+    virtual bool configLocked()
+    {
+        return false;
+    }
     /** Return the current SST-PP configuration level */
     virtual unsigned int currentLevel() = 0;
     /** Return the maximum valid SST-PP configuration level */
@@ -130,12 +227,24 @@ class SSTInterface
     /** Return the low priority base frequency for a given level. */
     virtual unsigned int bfLowPriorityFreq(unsigned int level) = 0;
 
-    /** Enable or disable SST-BF for the current configuration. */
-    virtual void setBfEnabled(bool enable) = 0;
-    /** Enable or disable SST-TF for the current configuration. */
-    virtual void setTfEnabled(bool enable) = 0;
+    /**
+     * Enable or disable SST-BF and SST-TF for the current configuration. Both
+     * are set by the same command, so they can only be changed together.
+     */
+    virtual void setBfTfEnabled(bool bfEnable, bool tfEnable) = 0;
     /** Change the current configuration to the given level. */
     virtual void setCurrentLevel(unsigned int level) = 0;
+
+    /**
+     * Called when the instance is kept for later, but won't be used for a
+     * while. Backends should give up anything which keeps the CPU awake, e.g.
+     * a Wake-On-PECI lease, but keep what they cached.
+     */
+    virtual void idle() {}
+
+  protected:
+    /** Package-scope registers read through this instance. */
+    PackageRegisterCache packageRegisters;
 };
 
 /**
@@ -187,5 +296,26 @@ using BackendProvider =
     } fn##Instance;
 void registerBackend(BackendProvider);
 
+/**
+ * Create the SSTInterface of a CPU, using the first registered backend which
+ * supports it.
+ *
+ * @param[in]   address     PECI address of the CPU.
+ * @param[in]   model       CPU model, as returned by GetCPUID.
+ * @param[in]   wakePolicy  Whether the instance may wake the CPU.
+ *
+ * @return  Backend instance, or nullptr if no backend supports the CPU or it
+ *          couldn't be created.
+ */
+std::unique_ptr<SSTInterface> getInstance(uint8_t address, CPUModel model,
+                                          WakePolicy wakePolicy);
+
+/**
+ * getInstance() remembers which provider supports each CPUModel, so the
+ * providers are only probed once per model. Forget those results, so that the
+ * next getInstance() probes all providers again.
+ */
+void invalidateBackendCache();
+
 } // namespace sst
 } // namespace cpu_info
@@ -0,0 +1,175 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "cpuinfo_cache.hpp"
+#include "speed_select.hpp"
+
+#include <peci.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <tuple>
+#include <vector>
+
+namespace cpu_info
+{
+namespace sst
+{
+
+/**
+ * Values of a single SST-PP config level, as read over PECI. This is plain data
+ * so that it can be gathered on the PECI worker and published on D-Bus from
+ * the io_context afterwards.
+ */
+struct LevelConfig
+{
+    unsigned int level;
+    uint32_t powerLimit;
+    uint32_t availableCoreCount;
+    uint32_t baseSpeed;
+    uint32_t maxSpeed;
+    uint32_t maxJunctionTemperature;
+    std::vector<std::tuple<uint32_t, std::vector<uint32_t>>>
+        baseSpeedPrioritySettings;
+    std::vector<TurboEntry> turboProfile;
+};
+
+/** Everything discovered about one SST-capable CPU. */
+struct CPUDiscovery
+{
+    unsigned int index;
+    CPUModel model;
+    unsigned int currentLevel;
+    bool bfEnabled;
+    /** Levels whose values were read, which always include the current one. */
+    std::vector<LevelConfig> levels;
+    /** Other supported levels, whose values are left to discoverLevel. */
+    std::vector<unsigned int> pendingLevels;
+    cache::CPUIdentity identity;
+    /**
+     * Backend instance the CPU was discovered with, if any levels are pending.
+     * Reading them through it reuses the mailbox responses and package
+     * registers it already read. It may hold a Wake-On-PECI lease, so drop it
+     * once the pending levels are read.
+     */
+    std::shared_ptr<SSTInterface> sst;
+};
+
+/** Outcome of SST discovery on a single socket. */
+enum class SocketStatus
+{
+    /** No SST-PP capable CPU at this address. */
+    absent,
+    /** CPU is present but can't be queried yet. Try again later. */
+    notReady,
+    /** CPU info was fully discovered. */
+    discovered
+};
+
+struct SocketDiscovery
+{
+    SocketStatus status;
+    CPUDiscovery cpu;
+};
+
+/**
+ * Retrieve the SST configuration info for the CPU at one PECI address. This
+ * only talks to PECI, and is meant to run on a PECI worker thread.
+ *
+ * Clients mostly look at the current level, so only its values are read,
+ * unless all levels were cached by an earlier discovery of the same CPU. The
+ * other supported levels are listed as pending.
+ *
+ * @param[in]   address PECI address of the socket.
+ * @param[in]   stop    Signalled if the discovery is cancelled, e.g. because
+ *                      the host powered off.
+ *
+ * @return  Status of the socket, with the CPU info if it was discovered.
+ *
+ * @throw PECIError     A PECI command failed on a CPU which had previously
+ *                      responded to a command.
+ */
+SocketDiscovery discoverCPU(uint8_t address, std::stop_token stop);
+
+/**
+ * Read the values of a single SST-PP level, e.g. one which discoverCPU left
+ * pending. This only talks to PECI, and is meant to run on a PECI worker
+ * thread. The instance must not be used by another thread at the same time.
+ *
+ * @param[in,out]   sst     Backend instance, preferably the one from
+ *                          discoverCPU.
+ * @param[in]       level   Level to read.
+ *
+ * @return  Values of the level.
+ *
+ * @throw PECIError     The CPU didn't respond, or a PECI command failed.
+ */
+LevelConfig discoverLevel(SSTInterface& sst, unsigned int level);
+
+/** SST control state of one CPU. */
+struct ControlState
+{
+    unsigned int level = 0;
+    bool bfEnabled = false;
+    bool tfEnabled = false;
+};
+
+/** Progress of applyConfig on one CPU. */
+struct ControlChange
+{
+    /** State before the change, which restoreConfig brings back. */
+    ControlState previous;
+    /** Set once any setter was sent, i.e. the CPU needs restoring. */
+    bool modified = false;
+};
+
+/**
+ * Apply an SST-PP level to one CPU, along with the SST-BF and SST-TF state if
+ * given, and read the result back. This only talks to PECI, and is meant to
+ * run on a PECI worker thread.
+ *
+ * @param[in]   address     PECI address of the socket.
+ * @param[in]   model       CPU model.
+ * @param[in]   level       Level to apply.
+ * @param[in]   bfEnabled   SST-BF state to apply, or nullopt to keep it.
+ * @param[in]   tfEnabled   SST-TF state to apply, or nullopt to keep it.
+ * @param[out]  change      Previous state and whether the CPU was changed. Also
+ *                          valid when this throws.
+ *
+ * @throw PECIError     A PECI command failed, or the CPU doesn't support the
+ *                      requested state.
+ */
+void applyConfig(uint8_t address, CPUModel model, unsigned int level,
+                 std::optional<bool> bfEnabled, std::optional<bool> tfEnabled,
+                 ControlChange& change);
+
+/**
+ * Bring one CPU back to an earlier SST control state, e.g. after applyConfig
+ * failed on another CPU. This only talks to PECI, and is meant to run on a
+ * PECI worker thread.
+ *
+ * @param[in]   address     PECI address of the socket.
+ * @param[in]   model       CPU model.
+ * @param[in]   state       State to restore.
+ *
+ * @throw PECIError     A PECI command failed.
+ */
+void restoreConfig(uint8_t address, CPUModel model, const ControlState& state);
+
+} // namespace sst
+} // namespace cpu_info
@@ -0,0 +1,83 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace cpu_info
+{
+namespace sst
+{
+
+/**
+ * How long Wake-On-PECI stays set after the last lease on a CPU is released.
+ * Operations usually come in bursts (discovery, or a Redfish request touching
+ * several properties), and this lets the whole burst share one wake/sleep
+ * cycle.
+ */
+static constexpr std::chrono::seconds wakeLeaseGracePeriod{2};
+
+/**
+ * Reference-counted lease on the Wake-On-PECI (WOP) mode bit of one CPU.
+ *
+ * Some PECI accesses (e.g. to the OS Mailbox) require the package to pop up to
+ * PC2. Since other applications may also be modifying WOP, we only set it when
+ * a command fails because the package is asleep, and only clear it if we set
+ * it ourselves.
+ *
+ * All users of a CPU share one lease, which is released a grace period after
+ * its last holder is done with it. Leases may be taken and dropped from any
+ * thread, but acquire() blocks on PECI so it must run on the PECI worker. The
+ * delayed release is itself run on the PECI worker.
+ */
+class WakeOnPECILease
+{
+  public:
+    explicit WakeOnPECILease(uint8_t address) : address(address) {}
+    ~WakeOnPECILease();
+
+    WakeOnPECILease(const WakeOnPECILease&) = delete;
+    WakeOnPECILease& operator=(const WakeOnPECILease&) = delete;
+    WakeOnPECILease(WakeOnPECILease&&) = delete;
+    WakeOnPECILease& operator=(WakeOnPECILease&&) = delete;
+
+    /**
+     * Set the WOP bit, and hold it until this object is destroyed. Meant to be
+     * called after a command failed because the package was asleep.
+     *
+     * @throw PECIError     Failed to set the WOP bit.
+     */
+    void acquire();
+
+    /**
+     * Join an existing lease, if WOP is currently set by us, so that it isn't
+     * released while this object is alive. Doesn't send any PECI command.
+     */
+    void join();
+
+    /**
+     * Release the lease early, e.g. when the owner is kept but idle. It is
+     * taken again by the next acquire() or join().
+     */
+    void release();
+
+  private:
+    uint8_t address;
+    bool held = false;
+};
+
+} // namespace sst
+} // namespace cpu_info
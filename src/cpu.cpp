@@ -118,6 +118,14 @@ void Cpu::characteristics(uint16_t value)
     processor::characteristics(result);
 }
 
+void Cpu::enrich(const CpuEnrichment& values)
+{
+    if (values.model)
+    {
+        asset::model(*values.model);
+    }
+}
+
 static constexpr uint8_t maxOldVersionCount = 0xff;
 void Cpu::infoUpdate(uint8_t* smbiosTableStorage,
                      const std::string& motherboard)
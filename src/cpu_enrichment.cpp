@@ -0,0 +1,315 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cpu_enrichment.hpp"
+
+#ifdef CPU_ENRICHMENT_PIROM
+#include "pirom.hpp"
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/container/flat_map.hpp>
+#include <phosphor-logging/lg2.hpp>
+#include <sdbusplus/bus/match.hpp>
+
+#include <chrono>
+#include <variant>
+
+#ifdef BOOST_ASIO_DISABLE_THREADS
+#error "The PIROM enrichment provider needs ASIO's thread support"
+#endif
+#endif
+
+namespace phosphor
+{
+namespace smbios
+{
+
+void CpuEnrichment::merge(const CpuEnrichment& other)
+{
+    if (other.model)
+    {
+        model = other.model;
+    }
+}
+
+#ifdef CPU_ENRICHMENT_PIROM
+/**
+ * Reads the PIROM of each CPU, at the address given by the XeonCPU
+ * configuration, and publishes its fields once two subsequent reads agree.
+ * The I2C transfers run on a thread of their own, so that a slow or hung
+ * PIROM doesn't block the D-Bus thread.
+ */
+class PiromEnrichment : public CpuEnrichmentProvider
+{
+  public:
+    PiromEnrichment(boost::asio::io_context& io,
+                    std::shared_ptr<sdbusplus::asio::connection> conn,
+                    CpuEnrichmentPublisher publish) :
+        io(io), conn(std::move(conn)), publish(std::move(publish)),
+        configTimer(io),
+        configMatch(
+            static_cast<sdbusplus::bus_t&>(*this->conn),
+            "type='signal',interface='org.freedesktop.DBus.Properties',"
+            "member='PropertiesChanged',arg0='" +
+                std::string(xeonCPUInterface) + "'",
+            [this](sdbusplus::message_t&) {
+                // EntityManager sets the properties one by one, so wait for
+                // it to settle.
+                configTimer.expires_after(configSettleTime);
+                configTimer.async_wait([this](boost::system::error_code ec) {
+                    if (!ec)
+                    {
+                        loadConfig();
+                    }
+                });
+            })
+    {
+        loadConfig();
+    }
+
+    void cpuUpdated(uint8_t cpuNum) override
+    {
+        // The PIROM is often only accessible with the host powered on, and a
+        // new SMBIOS table means the host has booted. Start over with a
+        // fresh retry budget if the PIROM hasn't been read yet.
+        auto socket = sockets.find(cpuNum);
+        if (socket == sockets.end() || socket->second.confirmed)
+        {
+            return;
+        }
+        socket->second.failedReads = 0;
+        tryReadPirom(cpuNum);
+    }
+
+  private:
+    static constexpr const char* xeonCPUInterface =
+        "xyz.openbmc_project.Configuration.XeonCPU";
+    static constexpr std::chrono::seconds configSettleTime{10};
+
+    using ConfigValue =
+        std::variant<std::vector<std::string>, std::string, int64_t,
+                     uint64_t, double, int32_t, uint32_t, int16_t, uint16_t,
+                     uint8_t, bool>;
+    using ConfigObjects = boost::container::flat_map<
+        sdbusplus::message::object_path,
+        boost::container::flat_map<
+            std::string,
+            boost::container::flat_map<std::string, ConfigValue>>>;
+
+    struct Socket
+    {
+        uint8_t i2cBus;
+        uint8_t i2cDevice;
+        /** Last PIROM fields read, until a second read confirms them. */
+        std::optional<cpu_info::PiromInfo> pirom;
+        bool confirmed = false;
+        /** Set while a read is in progress on the I2C thread. */
+        bool reading = false;
+        unsigned int failedReads = 0;
+        /** Tells the results of reads for an earlier config apart. */
+        unsigned int generation = 0;
+        std::optional<boost::asio::steady_timer> timer;
+    };
+
+    boost::asio::io_context& io;
+    std::shared_ptr<sdbusplus::asio::connection> conn;
+    CpuEnrichmentPublisher publish;
+    boost::asio::steady_timer configTimer;
+    sdbusplus::bus::match_t configMatch;
+
+    /** PIROM read state of each configured CPU, by 0-based CPU index. */
+    boost::container::flat_map<uint8_t, Socket> sockets;
+    unsigned int nextGeneration = 0;
+
+    /**
+     * Thread for the blocking I2C transfers. One thread is enough, since the
+     * PIROMs usually share a bus anyway. Declared last, so that it's joined
+     * before anything a running read refers to is destroyed.
+     */
+    boost::asio::thread_pool i2cThread{1};
+
+    void loadConfig()
+    {
+        conn->async_method_call(
+            [this](boost::system::error_code ec,
+                   const ConfigObjects& objects) {
+                if (ec)
+                {
+                    // No config data yet, so wait for the match
+                    return;
+                }
+                updateConfig(objects);
+            },
+            "xyz.openbmc_project.EntityManager",
+            "/xyz/openbmc_project/inventory",
+            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+    }
+
+    /**
+     * Start reading the PIROM of every CPU which is newly configured, or
+     * whose PIROM address changed.
+     */
+    void updateConfig(const ConfigObjects& objects)
+    {
+        for (const auto& [path, interfaces] : objects)
+        {
+            auto xeonCPU = interfaces.find(xeonCPUInterface);
+            if (xeonCPU == interfaces.end())
+            {
+                continue;
+            }
+            const auto& properties = xeonCPU->second;
+            auto getValue = [&properties](const char* name) -> const uint64_t* {
+                auto it = properties.find(name);
+                return it == properties.end()
+                           ? nullptr
+                           : std::get_if<uint64_t>(&it->second);
+            };
+
+            // CpuID is 1-based.
+            const uint64_t* cpuId = getValue("CpuID");
+            if (cpuId == nullptr || *cpuId == 0)
+            {
+                continue;
+            }
+            auto cpuNum = static_cast<uint8_t>(*cpuId - 1);
+            const uint64_t* i2cBus = getValue("PiromI2cBus");
+            const uint64_t* i2cDevice = getValue("PiromI2cAddress");
+            uint8_t bus = i2cBus ? static_cast<uint8_t>(*i2cBus)
+                                 : cpu_info::defaultI2cBus;
+            uint8_t device = i2cDevice
+                                 ? static_cast<uint8_t>(*i2cDevice)
+                                 : cpu_info::defaultI2cSlaveAddr0 + cpuNum;
+
+            auto socket = sockets.find(cpuNum);
+            if (socket != sockets.end() && socket->second.i2cBus == bus &&
+                socket->second.i2cDevice == device)
+            {
+                continue;
+            }
+            Socket& newSocket = sockets[cpuNum];
+            newSocket = Socket{};
+            newSocket.i2cBus = bus;
+            newSocket.i2cDevice = device;
+            newSocket.generation = nextGeneration++;
+            tryReadPirom(cpuNum);
+        }
+    }
+
+    /** Publish all fields decoded from a PIROM in one update. */
+    void publishPirom(uint8_t cpuNum, const cpu_info::PiromInfo& info)
+    {
+        CpuEnrichment values;
+        values.model = info.sSpec;
+        publish(cpuNum, values);
+    }
+
+    /**
+     * Start a PIROM read on the I2C thread, unless one is in progress already.
+     * The result is handled by piromRead on the D-Bus thread.
+     */
+    void tryReadPirom(uint8_t cpuNum)
+    {
+        Socket& socket = sockets[cpuNum];
+        if (socket.reading)
+        {
+            return;
+        }
+        socket.timer.reset();
+        socket.reading = true;
+
+        boost::asio::post(
+            i2cThread, [this, cpuNum, bus = socket.i2cBus,
+                        device = socket.i2cDevice,
+                        generation = socket.generation]() {
+                std::optional<cpu_info::PiromInfo> info =
+                    cpu_info::readPirom(bus, device);
+                boost::asio::post(io, [this, cpuNum, generation,
+                                       info = std::move(info)]() mutable {
+                    piromRead(cpuNum, generation, std::move(info));
+                });
+            });
+    }
+
+    /**
+     * Handle the result of a PIROM read, and retry until two subsequent reads
+     * are successful and return matching data. Then publish its fields.
+     */
+    void piromRead(uint8_t cpuNum, unsigned int generation,
+                   std::optional<cpu_info::PiromInfo> info)
+    {
+        auto it = sockets.find(cpuNum);
+        if (it == sockets.end() || it->second.generation != generation)
+        {
+            // The CPU was reconfigured while reading, and a new read started.
+            return;
+        }
+        Socket& socket = it->second;
+        socket.reading = false;
+
+        if (info && info == socket.pirom)
+        {
+            socket.confirmed = true;
+            publishPirom(cpuNum, *info);
+            return;
+        }
+
+        std::chrono::milliseconds retryDelay;
+        if (info)
+        {
+            retryDelay = cpu_info::sspecRetryMin;
+            socket.failedReads = 0;
+            socket.pirom = std::move(info);
+        }
+        else
+        {
+            if (++socket.failedReads > cpu_info::sspecMaxFailedReads)
+            {
+                lg2::error("PIROM read of CPU {CPU} failed too many times",
+                           "CPU", cpuNum);
+                return;
+            }
+            retryDelay = cpu_info::sspecRetryDelay(socket.failedReads);
+        }
+
+        socket.timer.emplace(io, retryDelay);
+        socket.timer->async_wait(
+            [this, cpuNum](boost::system::error_code ec) {
+                if (ec)
+                {
+                    return;
+                }
+                tryReadPirom(cpuNum);
+            });
+    }
+};
+#endif
+
+std::vector<std::unique_ptr<CpuEnrichmentProvider>> makeCpuEnrichmentProviders(
+    [[maybe_unused]] boost::asio::io_context& io,
+    [[maybe_unused]] const std::shared_ptr<sdbusplus::asio::connection>& conn,
+    [[maybe_unused]] const CpuEnrichmentPublisher& publish)
+{
+    std::vector<std::unique_ptr<CpuEnrichmentProvider>> providers;
+#ifdef CPU_ENRICHMENT_PIROM
+    providers.emplace_back(
+        std::make_unique<PiromEnrichment>(io, conn, publish));
+#endif
+    return providers;
+}
+
+} // namespace smbios
+} // namespace phosphor
@@ -0,0 +1,278 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cpuinfo_cache.hpp"
+
+#include "peci_instrumentation.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+namespace cpu_info
+{
+namespace cache
+{
+
+void to_json(nlohmann::json& j, const CPUIdentity& identity)
+{
+    j = nlohmann::json{{"model", static_cast<uint32_t>(identity.model)},
+                       {"stepping", identity.stepping},
+                       {"ppin", identity.ppin}};
+}
+
+void from_json(const nlohmann::json& j, CPUIdentity& identity)
+{
+    identity.model = static_cast<CPUModel>(j.at("model").get<uint32_t>());
+    j.at("stepping").get_to(identity.stepping);
+    j.at("ppin").get_to(identity.ppin);
+}
+
+std::optional<uint64_t> readPPIN(uint8_t address, CPUModel model)
+{
+    switch (model)
+    {
+        case iceLake:
+        case iceLakeD:
+        case sapphireRapids:
+        case emeraldRapids:
+        case graniteRapids:
+        case graniteRapidsD:
+        case sierraForest:
+        {
+            // PPIN can be read through PCS 19
+            static constexpr uint8_t u8Size = 4; // default to a DWORD
+            static constexpr uint8_t u8PPINPkgIndex = 19;
+            static constexpr uint16_t u16PPINPkgParamHigh = 2;
+            static constexpr uint16_t u16PPINPkgParamLow = 1;
+
+            auto readHalf = [address](uint16_t param)
+                -> std::optional<uint32_t> {
+                uint32_t u32PkgValue = 0;
+                uint8_t cc = 0;
+                EPECIStatus ret =
+                    peci::rdPkgConfig(address, u8PPINPkgIndex, param, u8Size,
+                                      (uint8_t*)&u32PkgValue, &cc);
+                if (ret != PECI_CC_SUCCESS || cc != PECI_DEV_CC_SUCCESS)
+                {
+                    phosphor::logging::log<phosphor::logging::level::ERR>(
+                        "peci read package config failed at address",
+                        phosphor::logging::entry("PECIADDR=0x%x",
+                                                 (unsigned)address),
+                        phosphor::logging::entry("CC=0x%x", cc));
+                    return std::nullopt;
+                }
+                return u32PkgValue;
+            };
+
+            std::optional<uint32_t> low = readHalf(u16PPINPkgParamLow);
+            if (!low)
+            {
+                return std::nullopt;
+            }
+            std::optional<uint32_t> high = readHalf(u16PPINPkgParamHigh);
+            if (!high)
+            {
+                return std::nullopt;
+            }
+            return static_cast<uint64_t>(*high) << 32 | *low;
+        }
+        default:
+            phosphor::logging::log<phosphor::logging::level::INFO>(
+                "in-compatible cpu for cpu asset info");
+            return 0;
+    }
+}
+
+std::optional<CPUIdentity> readIdentity(uint8_t address)
+{
+    CPUIdentity identity{};
+    uint8_t cc = 0;
+
+    if (peci::getCPUID(address, &identity.model, &identity.stepping, &cc) !=
+        PECI_CC_SUCCESS)
+    {
+        return std::nullopt;
+    }
+    std::optional<uint64_t> ppin = readPPIN(address, identity.model);
+    if (!ppin)
+    {
+        return std::nullopt;
+    }
+    identity.ppin = *ppin;
+    return identity;
+}
+
+/** Serializes access to the cache files, which are shared across threads. */
+static std::mutex cacheMutex;
+/** Directory holding the cache files. Guarded by cacheMutex. */
+static std::filesystem::path cacheDir = defaultCacheDir;
+
+void setCacheDir(std::filesystem::path dir)
+{
+    std::lock_guard lock(cacheMutex);
+    cacheDir = std::move(dir);
+}
+
+static std::filesystem::path cachePath(uint8_t address)
+{
+    return cacheDir /
+           ("cpu" + std::to_string(address - MIN_CLIENT_ADDR) + ".json");
+}
+
+static nlohmann::json readFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path);
+    if (!file.good())
+    {
+        return nlohmann::json::object();
+    }
+    nlohmann::json content = nlohmann::json::parse(file, nullptr, false);
+    if (!content.is_object())
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Discarding corrupt cpuinfo cache file",
+            phosphor::logging::entry("PATH=%s", path.c_str()));
+        return nlohmann::json::object();
+    }
+    return content;
+}
+
+std::optional<nlohmann::json> load(uint8_t address, std::string_view section)
+{
+    std::lock_guard lock(cacheMutex);
+    nlohmann::json content = readFile(cachePath(address));
+    auto it = content.find(std::string(section));
+    if (it == content.end())
+    {
+        return std::nullopt;
+    }
+    return *it;
+}
+
+/**
+ * Replace a cache file atomically. The caller must hold cacheMutex.
+ */
+static void writeFile(const std::filesystem::path& path,
+                      const nlohmann::json& content)
+{
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp";
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    if (ec)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Failed to create cpuinfo cache directory",
+            phosphor::logging::entry("ERROR=%s", ec.message().c_str()));
+        return;
+    }
+
+    {
+        std::ofstream file(tmpPath, std::ios_base::trunc);
+        file << content;
+        file.close();
+        if (!file.good())
+        {
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "Failed to write cpuinfo cache file",
+                phosphor::logging::entry("PATH=%s", tmpPath.c_str()));
+            std::filesystem::remove(tmpPath, ec);
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Failed to replace cpuinfo cache file",
+            phosphor::logging::entry("ERROR=%s", ec.message().c_str()));
+    }
+}
+
+void store(uint8_t address, std::string_view section,
+           const nlohmann::json& value)
+{
+    std::lock_guard lock(cacheMutex);
+    std::filesystem::path path = cachePath(address);
+    nlohmann::json content = readFile(path);
+    content[std::string(section)] = value;
+    writeFile(path, content);
+}
+
+void erase(uint8_t address, std::string_view section)
+{
+    std::lock_guard lock(cacheMutex);
+    std::filesystem::path path = cachePath(address);
+    nlohmann::json content = readFile(path);
+    if (content.erase(std::string(section)) != 0)
+    {
+        writeFile(path, content);
+    }
+}
+
+/** Cache section holding the identity of the CPU last seen in a socket. */
+static constexpr std::string_view ppinSection = "ppin";
+
+std::optional<uint64_t> loadPPIN(uint8_t address)
+{
+    std::optional<nlohmann::json> cached = load(address, ppinSection);
+    if (!cached)
+    {
+        return std::nullopt;
+    }
+    try
+    {
+        return cached->get<CPUIdentity>().ppin;
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Invalid PPIN cache entry",
+            phosphor::logging::entry("PECIADDR=0x%x", (unsigned)address),
+            phosphor::logging::entry("ERROR=%s", e.what()));
+        return std::nullopt;
+    }
+}
+
+std::optional<uint64_t> verifyPPIN(uint8_t address)
+{
+    std::optional<CPUIdentity> identity = readIdentity(address);
+    if (!identity)
+    {
+        return std::nullopt;
+    }
+
+    if (identity->ppin == 0)
+    {
+        erase(address, ppinSection);
+    }
+    else
+    {
+        nlohmann::json value = *identity;
+        if (load(address, ppinSection) != value)
+        {
+            store(address, ppinSection, value);
+        }
+    }
+    return identity->ppin;
+}
+
+} // namespace cache
+} // namespace cpu_info
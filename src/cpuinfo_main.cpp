@@ -16,29 +16,33 @@
 
 #include "cpuinfo.hpp"
 #include "cpuinfo_utils.hpp"
+#include "pirom.hpp"
 
 #include <errno.h>
-#include <fcntl.h>
 #include <stdio.h>
-#include <sys/ioctl.h>
 
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/awaitable.hpp>
 #include <boost/asio/io_service.hpp>
-#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/use_awaitable.hpp>
 #include <boost/container/flat_map.hpp>
+#include <boost/container/flat_set.hpp>
 
+#include <array>
 #include <iostream>
-#include <list>
+#include <map>
 #include <optional>
 #include <sstream>
 #include <string>
-
-extern "C"
-{
-#include <i2c/smbus.h>
-#include <linux/i2c-dev.h>
-}
+#include <unordered_map>
+#include <vector>
 
 #if PECI_ENABLED
+#include "cpuinfo_cache.hpp"
+#include "peci_instrumentation.hpp"
+#include "peci_readiness.hpp"
+#include "peci_worker.hpp"
 #include "speed_select.hpp"
 
 #include <peci.h>
@@ -50,21 +54,24 @@ extern "C"
 namespace cpu_info
 {
 static constexpr bool debug = false;
+
+using CPUInfoMap = boost::container::flat_map<size_t, std::shared_ptr<CPUInfo>>;
+
+static CPUInfoMap cpuInfoMap = {};
+
+#ifndef CPU_ENRICHMENT_PIROM
+// When smbiosmdrv2app reads the SSpec itself, it attaches it to its Cpu
+// objects directly, and none of the following is needed.
+
 static constexpr const char* assetInterfaceName =
     "xyz.openbmc_project.Inventory.Decorator.Asset";
 static constexpr const char* cpuProcessName =
     "xyz.openbmc_project.Smbios.MDR_V2";
 
-// constants for reading SSPEC or QDF string from PIROM
-// Currently, they are the same for platforms with Ice Lake
-static constexpr uint8_t defaultI2cBus = 13;
-static constexpr uint8_t defaultI2cSlaveAddr0 = 0x50;
-static constexpr uint8_t sspecRegAddr = 0xd;
-static constexpr uint8_t sspecSize = 6;
-
-using CPUInfoMap = boost::container::flat_map<size_t, std::shared_ptr<CPUInfo>>;
-
-static CPUInfoMap cpuInfoMap = {};
+static std::ostream& logStream(int cpu)
+{
+    return std::cerr << "[CPU " << cpu << "] ";
+}
 
 /**
  * Simple aggregate to define an external D-Bus property which needs to be set
@@ -78,17 +85,24 @@ struct CpuProperty
     std::string value;
 };
 
+/** Latest value of an external property, and whether it is known to be set. */
+struct PendingValue
+{
+    std::string value;
+    bool applied = false;
+};
+
 /**
- * List of properties we want to set on other D-Bus objects. This list is kept
- * around so that if any target objects are removed+re-added, then we can set
- * the values again.
+ * Properties we want to set on other D-Bus objects, keyed by object path, then
+ * interface and property name. Only the latest value of each property is kept,
+ * so that if any target objects are removed+re-added, then we can set the
+ * values again.
  */
-static std::list<CpuProperty> propertiesToSet;
-
-static std::ostream& logStream(int cpu)
-{
-    return std::cerr << "[CPU " << cpu << "] ";
-}
+static boost::container::flat_map<
+    std::string,
+    boost::container::flat_map<std::pair<std::string, std::string>,
+                               PendingValue>>
+    propertiesToSet;
 
 static void
     setCpuProperty(const std::shared_ptr<sdbusplus::asio::connection>& conn,
@@ -100,158 +114,98 @@ static void
 static void createCpuUpdatedMatch(
     const std::shared_ptr<sdbusplus::asio::connection>& conn, size_t cpu);
 
-static std::optional<std::string>
-    readSSpec(uint8_t bus, uint8_t slaveAddr, uint8_t regAddr, size_t count)
-{
-    unsigned long funcs = 0;
-    std::string devPath = "/dev/i2c-" + std::to_string(bus);
-
-    int fd = ::open(devPath.c_str(), O_RDWR);
-    if (fd < 0)
-    {
-        phosphor::logging::log<phosphor::logging::level::ERR>(
-            "Error in open!",
-            phosphor::logging::entry("PATH=%s", devPath.c_str()),
-            phosphor::logging::entry("SLAVEADDR=0x%x", slaveAddr));
-        return std::nullopt;
-    }
-
-    if (::ioctl(fd, I2C_FUNCS, &funcs) < 0)
-    {
-        phosphor::logging::log<phosphor::logging::level::ERR>(
-            "Error in I2C_FUNCS!",
-            phosphor::logging::entry("PATH=%s", devPath.c_str()),
-            phosphor::logging::entry("SLAVEADDR=0x%x", slaveAddr));
-        ::close(fd);
-        return std::nullopt;
-    }
-
-    if (!(funcs & I2C_FUNC_SMBUS_READ_BYTE_DATA))
-    {
-        phosphor::logging::log<phosphor::logging::level::ERR>(
-            "i2c bus does not support read!",
-            phosphor::logging::entry("PATH=%s", devPath.c_str()),
-            phosphor::logging::entry("SLAVEADDR=0x%x", slaveAddr));
-        ::close(fd);
-        return std::nullopt;
-    }
-
-    if (::ioctl(fd, I2C_SLAVE_FORCE, slaveAddr) < 0)
-    {
-        phosphor::logging::log<phosphor::logging::level::ERR>(
-            "Error in I2C_SLAVE_FORCE!",
-            phosphor::logging::entry("PATH=%s", devPath.c_str()),
-            phosphor::logging::entry("SLAVEADDR=0x%x", slaveAddr));
-        ::close(fd);
-        return std::nullopt;
-    }
-
-    int value = 0;
-    std::string sspec;
-    sspec.reserve(count);
-
-    for (size_t i = 0; i < count; i++)
-    {
-        value = ::i2c_smbus_read_byte_data(fd, regAddr + i);
-        if (value < 0)
-        {
-            phosphor::logging::log<phosphor::logging::level::ERR>(
-                "Error in i2c read!",
-                phosphor::logging::entry("PATH=%s", devPath.c_str()),
-                phosphor::logging::entry("SLAVEADDR=0x%x", slaveAddr));
-            ::close(fd);
-            return std::nullopt;
-        }
-        if (!std::isprint(static_cast<unsigned char>(value)))
-        {
-            phosphor::logging::log<phosphor::logging::level::ERR>(
-                "Non printable value in sspec, ignored.");
-            continue;
-        }
-        // sspec always starts with S,
-        // if not assume it is QDF string which starts at offset 2
-        if (i == 0 && static_cast<unsigned char>(value) != 'S')
-        {
-            i = 1;
-            continue;
-        }
-        sspec.push_back(static_cast<unsigned char>(value));
-    }
-    ::close(fd);
+/** PIROM reads in flight on each I2C bus. */
+static constexpr unsigned int i2cReadsPerBus = 1;
 
-    if (sspec.size() < 4)
-    {
-        return std::nullopt;
-    }
+static ResourceLimiter& i2cBusLimiter(uint8_t bus)
+{
+    static std::map<uint8_t, ResourceLimiter> limiters;
+    return limiters.try_emplace(bus, i2cReadsPerBus).first->second;
+}
 
-    return sspec;
+/**
+ * Publish the fields decoded from the PIROM of a CPU.
+ *
+ * @param[in,out]   conn    D-Bus connection.
+ * @param[in]       cpuInfo CPU to publish for.
+ * @param[in]       info    Decoded PIROM fields.
+ */
+static void
+    publishPirom(const std::shared_ptr<sdbusplus::asio::connection>& conn,
+                 const CPUInfo& cpuInfo, const PiromInfo& info)
+{
+    setCpuProperty(conn, cpuInfo.id, assetInterfaceName, "Model", info.sSpec);
 }
 
 /**
- * Higher level SSpec logic.
+ * Higher level PIROM logic.
  * This handles retrying the PIROM reads until two subsequent reads are
  * successful and return matching data. When we have confidence that the data
- * read is correct, then set the property on D-Bus.
+ * read is correct, then publish its fields on D-Bus. Each CPU retries
+ * independently so that a flaky PIROM on one socket can't use up the retry
+ * budget of the others.
+ *
+ * @param[in]   conn    D-Bus connection.
+ * @param[in]   cpuInfo CPU to read.
+ * @param[in]   scope   Task scope of the CPU.
  */
-static void tryReadSSpec(
-    const std::shared_ptr<sdbusplus::asio::connection>& conn, size_t cpuIndex)
+static boost::asio::awaitable<void>
+    readPiromTask(std::shared_ptr<sdbusplus::asio::connection> conn,
+                  std::shared_ptr<CPUInfo> cpuInfo,
+                  std::shared_ptr<TaskScope> scope)
 {
-    static int failedReads = 0;
-
-    auto cpuInfoIt = cpuInfoMap.find(cpuIndex);
-    if (cpuInfoIt == cpuInfoMap.end())
-    {
-        return;
-    }
-    auto cpuInfo = cpuInfoIt->second;
-
-    std::optional<std::string> newSSpec =
-        readSSpec(cpuInfo->i2cBus, cpuInfo->i2cDevice, sspecRegAddr, sspecSize);
-    logStream(cpuInfo->id) << "SSpec read status: "
-                           << static_cast<bool>(newSSpec) << "\n";
-    if (newSSpec && newSSpec == cpuInfo->sSpec)
+    unsigned int failedReads = 0;
+    while (true)
     {
-        setCpuProperty(conn, cpuInfo->id, assetInterfaceName, "Model",
-                       *newSSpec);
-        return;
-    }
+        std::optional<PiromInfo> info;
+        {
+            ResourceLimiter::Permit permit =
+                co_await i2cBusLimiter(cpuInfo->i2cBus).acquire(scope);
+            info = co_await runBlocking(
+                [bus = cpuInfo->i2cBus, device = cpuInfo->i2cDevice]() {
+                    return readPirom(bus, device);
+                });
+        }
+        scope->throwIfCancelled();
 
-    // If this read failed, back off for a little longer so that hopefully the
-    // transient condition affecting PIROM reads will pass, but give up after
-    // several consecutive failures. But if this read looked OK, try again
-    // sooner to confirm it.
-    int retrySeconds;
-    if (newSSpec)
-    {
-        retrySeconds = 1;
-        failedReads = 0;
-        cpuInfo->sSpec = *newSSpec;
-    }
-    else
-    {
-        retrySeconds = 5;
-        if (++failedReads > 10)
+        logStream(cpuInfo->id) << "PIROM read status: "
+                               << static_cast<bool>(info) << "\n";
+        if (info && info == cpuInfo->pirom)
         {
-            logStream(cpuInfo->id) << "PIROM Read failed too many times\n";
-            return;
+            cpuInfo->piromConfirmed = true;
+            publishPirom(conn, *cpuInfo, *info);
+            co_return;
         }
-    }
 
-    auto sspecTimer = std::make_shared<boost::asio::steady_timer>(
-        conn->get_io_context(), std::chrono::seconds(retrySeconds));
-    sspecTimer->async_wait(
-        [sspecTimer, conn, cpuIndex](boost::system::error_code ec) {
-            if (ec)
+        // If this read failed, back off exponentially so that hopefully the
+        // transient condition affecting PIROM reads will pass, but give up
+        // after several consecutive failures. But if this read looked OK, try
+        // again sooner to confirm it.
+        std::chrono::milliseconds retryDelay;
+        if (info)
+        {
+            retryDelay = sspecRetryMin;
+            failedReads = 0;
+            cpuInfo->pirom = std::move(info);
+        }
+        else
+        {
+            if (++failedReads > sspecMaxFailedReads)
             {
-                return;
+                logStream(cpuInfo->id) << "PIROM Read failed too many times\n";
+                co_return;
             }
-            tryReadSSpec(conn, cpuIndex);
-        });
+            retryDelay = sspecRetryDelay(failedReads);
+        }
+
+        co_await scope->sleep(retryDelay);
+    }
 }
 
 /**
  * Add a D-Bus property to the global list, and attempt to set it by calling
- * `setDbusProperty`.
+ * `setDbusProperty`. Nothing is sent if the property was already set to the
+ * same value.
  *
  * @param[in,out]   conn        D-Bus connection.
  * @param[in]       cpu         1-based CPU index.
@@ -268,16 +222,23 @@ static void
     // dbus object path used by smbios is 0 based
     const std::string objectPath = cpuPath + std::to_string(cpu - 1);
 
-    // Can switch to emplace_back if you define a CpuProperty constructor.
-    propertiesToSet.push_back(
-        CpuProperty{objectPath, interface, propName, propVal});
+    PendingValue& pending = propertiesToSet[objectPath][{interface, propName}];
+    if (pending.applied && pending.value == propVal)
+    {
+        return;
+    }
+    pending.value = propVal;
+    pending.applied = false;
 
-    setDbusProperty(conn, cpu, propertiesToSet.back());
+    setDbusProperty(conn, cpu,
+                    CpuProperty{objectPath, interface, propName, propVal});
 }
 
 /**
  * Set a D-Bus property which is already contained in the global list, and also
- * setup a D-Bus match to make sure the target property stays correct.
+ * setup a D-Bus match to make sure the target property stays correct. Once the
+ * Set succeeds, the property is marked as applied, unless a newer value was
+ * requested in the meantime.
  *
  * @param[in,out]   conn    D-Bus connection.
  * @param[in]       cpu     1-baesd CPU index.
@@ -289,13 +250,25 @@ static void
 {
     createCpuUpdatedMatch(conn, cpu);
     conn->async_method_call(
-        [](const boost::system::error_code ec) {
+        [newProp](const boost::system::error_code ec) {
             if (ec)
             {
                 phosphor::logging::log<phosphor::logging::level::ERR>(
                     "Cannot set CPU property!");
                 return;
             }
+            auto object = propertiesToSet.find(newProp.object);
+            if (object == propertiesToSet.end())
+            {
+                return;
+            }
+            auto prop =
+                object->second.find({newProp.interface, newProp.name});
+            if (prop != object->second.end() &&
+                prop->second.value == newProp.value)
+            {
+                prop->second.applied = true;
+            }
         },
         cpuProcessName, newProp.object.c_str(),
         "org.freedesktop.DBus.Properties", "Set", newProp.interface,
@@ -303,9 +276,57 @@ static void
 }
 
 /**
- * Set up a D-Bus match (if one does not already exist) to watch for any new
- * interfaces on the cpu object. When new interfaces are added, re-send all
- * properties targeting that object/interface.
+ * Interfaces added to each object since its properties were last replayed.
+ * smbios-mdr may add the interfaces of an object in several signals, so the
+ * replay is deferred until those have been handled, and then sends one Set
+ * per property.
+ */
+static boost::container::flat_map<std::string,
+                                  boost::container::flat_set<std::string>>
+    pendingReplays;
+
+/**
+ * Re-send all properties targeting the interfaces recently added to an object.
+ *
+ * @param[in,out]   conn        D-Bus connection.
+ * @param[in]       cpu         1-based CPU index.
+ * @param[in]       objectPath  Object to replay the properties of.
+ */
+static void
+    replayProperties(const std::shared_ptr<sdbusplus::asio::connection>& conn,
+                     size_t cpu, const std::string& objectPath)
+{
+    auto replay = pendingReplays.find(objectPath);
+    if (replay == pendingReplays.end())
+    {
+        return;
+    }
+    boost::container::flat_set<std::string> interfaces =
+        std::move(replay->second);
+    pendingReplays.erase(replay);
+
+    auto object = propertiesToSet.find(objectPath);
+    if (object == propertiesToSet.end())
+    {
+        return;
+    }
+    for (auto& [key, pending] : object->second)
+    {
+        const auto& [interface, name] = key;
+        if (interfaces.contains(interface))
+        {
+            pending.applied = false;
+            setDbusProperty(conn, cpu,
+                            CpuProperty{objectPath, interface, name,
+                                        pending.value});
+        }
+    }
+}
+
+/**
+ * Watch for new interfaces on the cpu object, using a single D-Bus match for
+ * all CPUs which is set up the first time this is called. When new interfaces
+ * are added, re-send all properties targeting that object/interface.
  *
  * @param[in,out]   conn    D-Bus connection.
  * @param[in]       cpu     1-based CPU index.
@@ -313,260 +334,385 @@ static void
 static void createCpuUpdatedMatch(
     const std::shared_ptr<sdbusplus::asio::connection>& conn, size_t cpu)
 {
-    static boost::container::flat_map<size_t,
-                                      std::unique_ptr<sdbusplus::bus::match_t>>
-        cpuUpdatedMatch;
+    // 1-based CPU index of each watched object.
+    static std::unordered_map<std::string, size_t> cpuObjects;
+    static std::unique_ptr<sdbusplus::bus::match_t> cpuUpdatedMatch;
 
-    if (cpuUpdatedMatch[cpu])
+    cpuObjects.try_emplace(cpuPath + std::to_string(cpu - 1), cpu);
+    if (cpuUpdatedMatch)
     {
         return;
     }
 
-    const std::string objectPath = cpuPath + std::to_string(cpu - 1);
-
-    cpuUpdatedMatch.insert_or_assign(
-        cpu,
-        std::make_unique<sdbusplus::bus::match_t>(
-            static_cast<sdbusplus::bus_t&>(*conn),
-            sdbusplus::bus::match::rules::interfacesAdded() +
-                sdbusplus::bus::match::rules::argNpath(0, objectPath.c_str()),
-            [conn, cpu](sdbusplus::message_t& msg) {
-                sdbusplus::message::object_path objectName;
+    // InterfacesAdded is sent from the ObjectManager path, so path_namespace
+    // can't select the CPUs. Instead match on the parent of the CPU objects
+    // in arg0, and ignore its other children here.
+    std::string cpuParent(cpuPath);
+    cpuParent.resize(cpuParent.rfind('/') + 1);
+
+    cpuUpdatedMatch = std::make_unique<sdbusplus::bus::match_t>(
+        static_cast<sdbusplus::bus_t&>(*conn),
+        sdbusplus::bus::match::rules::interfacesAdded() +
+            sdbusplus::bus::match::rules::argNpath(0, cpuParent),
+        [conn](sdbusplus::message_t& msg) {
+            sdbusplus::message::object_path objectName;
+            boost::container::flat_map<
+                std::string,
                 boost::container::flat_map<
-                    std::string,
-                    boost::container::flat_map<
-                        std::string, std::variant<std::string, uint64_t>>>
-                    msgData;
-
-                msg.read(objectName, msgData);
-
-                // Go through all the property changes, and retry all of them
-                // targeting this object/interface which was just added.
-                for (const CpuProperty& prop : propertiesToSet)
-                {
-                    if (prop.object == objectName &&
-                        msgData.contains(prop.interface))
-                    {
-                        setDbusProperty(conn, cpu, prop);
-                    }
-                }
-            }));
+                    std::string, std::variant<std::string, uint64_t>>>
+                msgData;
+
+            msg.read(objectName, msgData);
+
+            auto cpuObject = cpuObjects.find(objectName.str);
+            if (cpuObject == cpuObjects.end())
+            {
+                return;
+            }
+            size_t cpu = cpuObject->second;
+
+            // Retry all the property changes targeting the interfaces which
+            // were just added, once per burst of signals.
+            auto [replay, first] = pendingReplays.try_emplace(objectName.str);
+            for (const auto& [interface, _] : msgData)
+            {
+                replay->second.insert(interface);
+            }
+            if (first)
+            {
+                boost::asio::post(conn->get_io_context(),
+                                  [conn, cpu, objectPath = objectName.str]() {
+                                      replayProperties(conn, cpu, objectPath);
+                                  });
+            }
+        });
 }
+#endif
 
 #if PECI_ENABLED
-static void getPPIN(boost::asio::io_service& io,
-                    const std::shared_ptr<sdbusplus::asio::connection>& conn,
-                    const size_t& cpu)
+/**
+ * Publish a PPIN as the UniqueIdentifier of a CPU. Nothing is sent if it
+ * didn't change.
+ *
+ * @param[in,out]   conn    D-Bus connection.
+ * @param[in,out]   cpuInfo CPU to publish for.
+ * @param[in]       ppin    PPIN, or 0 if there is none, in which case any
+ *                          UniqueIdentifier published earlier is removed.
+ */
+static void
+    publishPPIN(const std::shared_ptr<sdbusplus::asio::connection>& conn,
+                CPUInfo& cpuInfo, uint64_t ppin)
 {
-    if (cpuInfoMap.find(cpu) == cpuInfoMap.end() || cpuInfoMap[cpu] == nullptr)
-    {
-        std::cerr << "No information found for cpu " << cpu << "\n";
-        return;
-    }
-
-    std::shared_ptr<CPUInfo> cpuInfo = cpuInfoMap[cpu];
-
-    if (cpuInfo->id != cpu)
+    if (ppin == 0)
     {
-        std::cerr << "Incorrect CPU id " << (unsigned)cpuInfo->id << " expect "
-                  << cpu << "\n";
+        // It may have come from the cache, and belong to a CPU which was
+        // since replaced.
+        cpuInfo.uuidInterface.reset();
         return;
     }
+    std::stringstream stream;
+    stream << std::hex << ppin;
+    cpuInfo.publishUUID(*conn, stream.str());
+}
 
-    uint8_t cpuAddr = cpuInfo->peciAddr;
-
-    uint8_t cc = 0;
-    CPUModel model{};
-    uint8_t stepping = 0;
-
-    // Wait for POST to complete to ensure that BIOS has time to enable the
-    // PPIN. Before BIOS enables it, we would get a 0x90 CC on PECI.
-    if (hostState != HostState::postComplete ||
-        peci_GetCPUID(cpuAddr, &model, &stepping, &cc) != PECI_CC_SUCCESS)
+/**
+ * Publish the PPIN cached during an earlier boot. Reading the PPIN has to wait
+ * for POST to complete, so this makes it available right away. readPPINTask
+ * verifies it later.
+ *
+ * @param[in,out]   conn    D-Bus connection.
+ * @param[in,out]   cpuInfo CPU to publish for.
+ */
+static void
+    publishCachedPPIN(const std::shared_ptr<sdbusplus::asio::connection>& conn,
+                      CPUInfo& cpuInfo)
+{
+    if (std::optional<uint64_t> ppin = cache::loadPPIN(cpuInfo.peciAddr))
     {
-        // Start the PECI check loop
-        auto waitTimer = std::make_shared<boost::asio::steady_timer>(io);
-        waitTimer->expires_after(
-            std::chrono::seconds(cpu_info::peciCheckInterval));
-
-        waitTimer->async_wait(
-            [waitTimer, &io, conn, cpu](const boost::system::error_code& ec) {
-                if (ec)
-                {
-                    // operation_aborted is expected if timer is canceled
-                    // before completion.
-                    if (ec != boost::asio::error::operation_aborted)
-                    {
-                        phosphor::logging::log<phosphor::logging::level::ERR>(
-                            "info update timer async_wait failed ",
-                            phosphor::logging::entry("EC=0x%x", ec.value()));
-                    }
-                    return;
-                }
-                getPPIN(io, conn, cpu);
-            });
-        return;
+        publishPPIN(conn, cpuInfo, *ppin);
     }
+}
 
-    switch (model)
-    {
-        case iceLake:
-        case iceLakeD:
-        case sapphireRapids:
-        case emeraldRapids:
-        case graniteRapids:
-        case graniteRapidsD:
-        case sierraForest:
-        {
-            // PPIN can be read through PCS 19
-            static constexpr uint8_t u8Size = 4; // default to a DWORD
-            static constexpr uint8_t u8PPINPkgIndex = 19;
-            static constexpr uint16_t u16PPINPkgParamHigh = 2;
-            static constexpr uint16_t u16PPINPkgParamLow = 1;
-            uint64_t cpuPPIN = 0;
-            uint32_t u32PkgValue = 0;
-
-            int ret =
-                peci_RdPkgConfig(cpuAddr, u8PPINPkgIndex, u16PPINPkgParamLow,
-                                 u8Size, (uint8_t*)&u32PkgValue, &cc);
-            if (0 != ret)
+/**
+ * Wait for a CPU to respond to PECI. If the host powers off first, the
+ * awaiting coroutine is destroyed without resuming.
+ *
+ * @param[in]   address PECI address of the CPU.
+ * @param[in]   retry   Probe the CPU again, because its last command failed.
+ *
+ * @return  False if PECI reported that the socket is empty.
+ */
+static boost::asio::awaitable<bool> cpuReady(uint8_t address, bool retry)
+{
+    co_return co_await boost::asio::async_initiate<
+        const boost::asio::use_awaitable_t<>, void(bool)>(
+        [address, retry](auto handler) {
+            auto shared =
+                std::make_shared<decltype(handler)>(std::move(handler));
+            peci::ReadyHandler ready = [shared](bool present) {
+                std::move (*shared)(present);
+            };
+            if (retry)
             {
-                phosphor::logging::log<phosphor::logging::level::ERR>(
-                    "peci read package config failed at address",
-                    phosphor::logging::entry("PECIADDR=0x%x",
-                                             (unsigned)cpuAddr),
-                    phosphor::logging::entry("CC=0x%x", cc));
-                u32PkgValue = 0;
+                peci::retryWhenReady(address, std::move(ready));
             }
-
-            cpuPPIN = u32PkgValue;
-            ret = peci_RdPkgConfig(cpuAddr, u8PPINPkgIndex, u16PPINPkgParamHigh,
-                                   u8Size, (uint8_t*)&u32PkgValue, &cc);
-            if (0 != ret)
+            else
             {
-                phosphor::logging::log<phosphor::logging::level::ERR>(
-                    "peci read package config failed at address",
-                    phosphor::logging::entry("PECIADDR=0x%x",
-                                             (unsigned)cpuAddr),
-                    phosphor::logging::entry("CC=0x%x", cc));
-                cpuPPIN = 0;
-                u32PkgValue = 0;
+                peci::whenReady(address, std::move(ready));
             }
+        },
+        boost::asio::use_awaitable);
+}
+
+/**
+ * Read the PPIN of a CPU once it responds to PECI, and publish it. This
+ * replaces the cached value if it was wrong, and withdraws it if the CPU
+ * reports no PPIN.
+ *
+ * @param[in]   conn    D-Bus connection.
+ * @param[in]   cpuInfo CPU to read.
+ * @param[in]   scope   Task scope of the CPU.
+ */
+static boost::asio::awaitable<void>
+    readPPINTask(std::shared_ptr<sdbusplus::asio::connection> conn,
+                 std::shared_ptr<CPUInfo> cpuInfo,
+                 std::shared_ptr<TaskScope> scope)
+{
+    uint8_t cpuAddr = cpuInfo->peciAddr;
+    bool retry = false;
+    while (true)
+    {
+        if (!co_await cpuReady(cpuAddr, retry))
+        {
+            co_return;
+        }
+        scope->throwIfCancelled();
 
-            cpuPPIN |= static_cast<uint64_t>(u32PkgValue) << 32;
+        // Like all PECI work, this runs on the PECI worker, which bounds how
+        // many PECI requests run at once.
+        std::optional<uint64_t> cpuPPIN = co_await peci::getWorker().post(
+            [cpuAddr]() { return cache::verifyPPIN(cpuAddr); },
+            boost::asio::use_awaitable);
+        scope->throwIfCancelled();
 
-            // set SerialNumber if cpuPPIN is valid
-            if (0 != cpuPPIN)
-            {
-                std::stringstream stream;
-                stream << std::hex << cpuPPIN;
-                std::string serialNumber(stream.str());
-                cpuInfo->publishUUID(*conn, serialNumber);
-            }
-            break;
+        if (cpuPPIN)
+        {
+            peci::confirmReady(cpuAddr);
+            publishPPIN(conn, *cpuInfo, *cpuPPIN);
+            co_return;
         }
-        default:
-            phosphor::logging::log<phosphor::logging::level::INFO>(
-                "in-compatible cpu for cpu asset info");
-            break;
+        // Stopped responding, or the PPIN couldn't be read, so try again
+        // once it responds. The cached PPIN stays published meanwhile.
+        retry = true;
     }
 }
 #endif
 
 /**
- * Get cpu and pirom address
+ * Start reading the PIROM and PPIN of a CPU, as far as the host state allows,
+ * in the current task scope of the CPU.
+ *
+ * @param[in]   conn    D-Bus connection.
+ * @param[in]   cpuInfo CPU to read.
+ */
+static void startCpuTasks(
+    [[maybe_unused]] const std::shared_ptr<sdbusplus::asio::connection>& conn,
+    [[maybe_unused]] const std::shared_ptr<CPUInfo>& cpuInfo)
+{
+#ifndef CPU_ENRICHMENT_PIROM
+    if (!cpuInfo->piromConfirmed)
+    {
+        spawnTask(conn->get_io_context(),
+                  readPiromTask(conn, cpuInfo, cpuInfo->tasks),
+                  "PIROM read of CPU " + std::to_string(cpuInfo->id));
+    }
+#endif
+
+#if PECI_ENABLED
+    // Wait for POST to complete to ensure that BIOS has time to enable the
+    // PPIN. Before BIOS enables it, we would get a 0x90 CC on PECI. The host
+    // state callback starts over once it does.
+    if (hostState == HostState::postComplete)
+    {
+        spawnTask(conn->get_io_context(),
+                  readPPINTask(conn, cpuInfo, cpuInfo->tasks),
+                  "PPIN read of CPU " + std::to_string(cpuInfo->id));
+    }
+#endif
+}
+
+/**
+ * Cancel the reads of every CPU and start over in fresh task scopes. A
+ * power-off ends PECI reads right away, and PIROM access often depends on the
+ * host power state, so any other state change is a good time to try again
+ * with a fresh retry budget.
+ *
+ * @param[in]   conn    D-Bus connection.
  */
 static void
-    getCpuAddress(boost::asio::io_service& io,
-                  const std::shared_ptr<sdbusplus::asio::connection>& conn,
-                  const std::string& service, const std::string& object,
-                  const std::string& interface)
+    restartCpuTasks(const std::shared_ptr<sdbusplus::asio::connection>& conn)
 {
-    conn->async_method_call(
-        [&io, conn](boost::system::error_code ec,
-                    const boost::container::flat_map<
-                        std::string,
-                        std::variant<std::string, uint64_t, uint32_t, uint16_t,
-                                     std::vector<std::string>>>& properties) {
-            const uint64_t* value = nullptr;
-            std::optional<uint8_t> peciAddress;
-            uint8_t i2cBus = defaultI2cBus;
-            std::optional<uint8_t> i2cDevice;
-            std::optional<size_t> cpu;
+    for (const auto& [cpu, cpuInfo] : cpuInfoMap)
+    {
+        cpuInfo->tasks->cancel();
+        cpuInfo->tasks = std::make_shared<TaskScope>();
+        startCpuTasks(conn, cpuInfo);
+    }
+}
 
-            if (ec)
-            {
-                std::cerr << "DBUS response error " << ec.value() << ": "
-                          << ec.message() << "\n";
-                return;
-            }
+static constexpr const char* xeonCPUInterface =
+    "xyz.openbmc_project.Configuration.XeonCPU";
 
-            for (const auto& property : properties)
-            {
-                std::cerr << "property " << property.first << "\n";
-                if (property.first == "Address")
-                {
-                    value = std::get_if<uint64_t>(&property.second);
-                    if (value != nullptr)
-                    {
-                        peciAddress = static_cast<uint8_t>(*value);
-                    }
-                }
-                if (property.first == "CpuID")
-                {
-                    value = std::get_if<uint64_t>(&property.second);
-                    if (value != nullptr)
-                    {
-                        cpu = static_cast<size_t>(*value);
-                    }
-                }
-                if (property.first == "PiromI2cAddress")
-                {
-                    value = std::get_if<uint64_t>(&property.second);
-                    if (value != nullptr)
-                    {
-                        i2cDevice = static_cast<uint8_t>(*value);
-                    }
-                }
-                if (property.first == "PiromI2cBus")
-                {
-                    value = std::get_if<uint64_t>(&property.second);
-                    if (value != nullptr)
-                    {
-                        i2cBus = static_cast<uint8_t>(*value);
-                    }
-                }
-            }
+/** Types EntityManager uses for configuration properties. */
+using ConfigValue =
+    std::variant<std::vector<std::string>, std::string, int64_t, uint64_t,
+                 double, int32_t, uint32_t, int16_t, uint16_t, uint8_t, bool>;
+using ConfigObjects = boost::container::flat_map<
+    sdbusplus::message::object_path,
+    boost::container::flat_map<
+        std::string, boost::container::flat_map<std::string, ConfigValue>>>;
 
-            if (!cpu || !peciAddress)
-            {
-                return;
-            }
+/** Addresses of a CPU, as configured by an XeonCPU object. */
+struct CpuConfig
+{
+    uint8_t peciAddress;
+    uint8_t i2cBus;
+    uint8_t i2cDevice;
+};
 
-            if (!i2cDevice)
-            {
-                i2cDevice = defaultI2cSlaveAddr0 + *cpu - 1;
-            }
+/**
+ * Get cpu and pirom address from the properties of an XeonCPU object.
+ *
+ * @param[in]   properties  XeonCPU properties.
+ * @param[out]  cpu         1-based CPU index.
+ *
+ * @return  CPU addresses, or nullopt if the CPU ID or address is missing.
+ */
+static std::optional<CpuConfig> parseCpuConfig(
+    const boost::container::flat_map<std::string, ConfigValue>& properties,
+    size_t& cpu)
+{
+    auto getValue = [&properties](const char* name) -> const uint64_t* {
+        auto it = properties.find(name);
+        return it == properties.end() ? nullptr
+                                      : std::get_if<uint64_t>(&it->second);
+    };
+
+    const uint64_t* cpuId = getValue("CpuID");
+    const uint64_t* peciAddress = getValue("Address");
+    if (cpuId == nullptr || peciAddress == nullptr)
+    {
+        return std::nullopt;
+    }
+    cpu = static_cast<size_t>(*cpuId);
+
+    CpuConfig config{};
+    config.peciAddress = static_cast<uint8_t>(*peciAddress);
+    const uint64_t* i2cBus = getValue("PiromI2cBus");
+    config.i2cBus = i2cBus ? static_cast<uint8_t>(*i2cBus) : defaultI2cBus;
+    const uint64_t* i2cDevice = getValue("PiromI2cAddress");
+    config.i2cDevice = i2cDevice ? static_cast<uint8_t>(*i2cDevice)
+                                 : defaultI2cSlaveAddr0 + cpu - 1;
+    return config;
+}
 
-            auto key = cpuInfoMap.find(*cpu);
+/**
+ * Bring cpuInfoMap in line with the XeonCPU configuration. CPUs which are no
+ * longer configured are removed, and CPUs which are new or whose PECI or I2C
+ * address changed are (re)created and have their PIROM and PPIN read. CPUs
+ * whose configuration didn't change are left alone.
+ *
+ * @param[in,out]   conn    D-Bus connection.
+ * @param[in]       objects All EntityManager objects.
+ */
+static void updateCpuConfiguration(
+    const std::shared_ptr<sdbusplus::asio::connection>& conn,
+    const ConfigObjects& objects)
+{
+    boost::container::flat_map<size_t, CpuConfig> configs;
+    for (const auto& [path, interfaces] : objects)
+    {
+        auto xeonCPU = interfaces.find(xeonCPUInterface);
+        if (xeonCPU == interfaces.end())
+        {
+            continue;
+        }
+        size_t cpu = 0;
+        std::optional<CpuConfig> config = parseCpuConfig(xeonCPU->second, cpu);
+        if (config)
+        {
+            configs.insert_or_assign(cpu, *config);
+        }
+    }
 
-            if (key != cpuInfoMap.end())
-            {
-                cpuInfoMap.erase(key);
-            }
+    for (auto it = cpuInfoMap.begin(); it != cpuInfoMap.end();)
+    {
+        if (configs.contains(it->first))
+        {
+            ++it;
+            continue;
+        }
+        std::cerr << "CPU " << it->first << " is no longer configured\n";
+        it->second->tasks->cancel();
+        it = cpuInfoMap.erase(it);
+    }
 
-            cpuInfoMap.emplace(*cpu,
-                               std::make_shared<CPUInfo>(*cpu, *peciAddress,
-                                                         i2cBus, *i2cDevice));
+    for (const auto& [cpu, config] : configs)
+    {
+        auto existing = cpuInfoMap.find(cpu);
+        if (existing != cpuInfoMap.end() &&
+            existing->second->peciAddr == config.peciAddress &&
+            existing->second->i2cBus == config.i2cBus &&
+            existing->second->i2cDevice == config.i2cDevice)
+        {
+            continue;
+        }
+        if (existing != cpuInfoMap.end())
+        {
+            existing->second->tasks->cancel();
+        }
 
-            tryReadSSpec(conn, *cpu);
+        auto cpuInfo = std::make_shared<CPUInfo>(
+            cpu, config.peciAddress, config.i2cBus, config.i2cDevice);
+        cpuInfoMap.insert_or_assign(cpu, cpuInfo);
 
 #if PECI_ENABLED
-            getPPIN(io, conn, *cpu);
+        publishCachedPPIN(conn, *cpuInfo);
 #endif
-        },
-        service, object, "org.freedesktop.DBus.Properties", "GetAll",
-        interface);
+        startCpuTasks(conn, cpuInfo);
+    }
+}
+
+/**
+ * Load the XeonCPU configuration and apply it.
+ *
+ * @param[in]   conn    D-Bus connection.
+ * @param[in]   scope   Scope of the load, which is cancelled by a newer one.
+ * @param[in]   delay   Time to wait before loading.
+ */
+static boost::asio::awaitable<void>
+    loadCpuConfiguration(std::shared_ptr<sdbusplus::asio::connection> conn,
+                         std::shared_ptr<TaskScope> scope,
+                         std::chrono::seconds delay)
+{
+    co_await scope->sleep(delay);
+
+    ConfigObjects objects;
+    try
+    {
+        objects = co_await methodCall<ConfigObjects>(
+            conn, "xyz.openbmc_project.EntityManager",
+            "/xyz/openbmc_project/inventory",
+            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+    }
+    catch (const boost::system::system_error& e)
+    {
+        // No config data yet, so wait for the match
+        std::cerr << "error getting configuration: " << e.what() << "\n";
+        co_return;
+    }
+    scope->throwIfCancelled();
+    updateCpuConfiguration(conn, objects);
 }
 
 /**
@@ -574,9 +720,10 @@ static void
  */
 static void getCpuConfiguration(
     boost::asio::io_service& io,
-    const std::shared_ptr<sdbusplus::asio::connection>& conn,
-    sdbusplus::asio::object_server& objServer)
+    const std::shared_ptr<sdbusplus::asio::connection>& conn)
 {
+    static std::shared_ptr<TaskScope> loader = std::make_shared<TaskScope>();
+
     // Get the Cpu configuration
     // In case it's not available, set a match for it
     static std::unique_ptr<sdbusplus::bus::match_t> cpuConfigMatch =
@@ -585,68 +732,22 @@ static void getCpuConfiguration(
             "type='signal',interface='org.freedesktop.DBus.Properties',member='"
             "PropertiesChanged',arg0='xyz.openbmc_project."
             "Configuration.XeonCPU'",
-            [&io, conn, &objServer](sdbusplus::message_t& /* msg */) {
+            [&io, conn](sdbusplus::message_t& /* msg */) {
                 std::cerr << "get cpu configuration match\n";
-                static boost::asio::steady_timer filterTimer(io);
-                filterTimer.expires_after(
-                    std::chrono::seconds(configCheckInterval));
-
-                filterTimer.async_wait(
-                    [&io, conn,
-                     &objServer](const boost::system::error_code& ec) {
-                        if (ec == boost::asio::error::operation_aborted)
-                        {
-                            return; // we're being canceled
-                        }
-                        else if (ec)
-                        {
-                            std::cerr << "Error: " << ec.message() << "\n";
-                            return;
-                        }
-                        getCpuConfiguration(io, conn, objServer);
-                    });
+                // EntityManager sets the properties one by one, so only load
+                // the configuration once the last change settled.
+                loader->cancel();
+                loader = std::make_shared<TaskScope>();
+                spawnTask(io,
+                          loadCpuConfiguration(
+                              conn, loader,
+                              std::chrono::seconds(configCheckInterval)),
+                          "CPU configuration");
             });
 
-    conn->async_method_call(
-        [&io, conn](
-            boost::system::error_code ec,
-            const std::vector<std::pair<
-                std::string,
-                std::vector<std::pair<std::string, std::vector<std::string>>>>>&
-                subtree) {
-            if constexpr (debug)
-                std::cerr << "async_method_call callback\n";
-
-            if (ec)
-            {
-                std::cerr << "error with async_method_call\n";
-                return;
-            }
-            if (subtree.empty())
-            {
-                // No config data yet, so wait for the match
-                return;
-            }
-
-            for (const auto& object : subtree)
-            {
-                for (const auto& service : object.second)
-                {
-                    getCpuAddress(io, conn, service.first, object.first,
-                                  "xyz.openbmc_project.Configuration.XeonCPU");
-                }
-            }
-            if constexpr (debug)
-                std::cerr << "getCpuConfiguration callback complete\n";
-
-            return;
-        },
-        "xyz.openbmc_project.ObjectMapper",
-        "/xyz/openbmc_project/object_mapper",
-        "xyz.openbmc_project.ObjectMapper", "GetSubTree",
-        "/xyz/openbmc_project/", 0,
-        std::array<const char*, 1>{
-            "xyz.openbmc_project.Configuration.XeonCPU"});
+    spawnTask(io,
+              loadCpuConfiguration(conn, loader, std::chrono::seconds(0)),
+              "CPU configuration");
 }
 
 } // namespace cpu_info
@@ -660,21 +761,36 @@ int main()
 
     // CPUInfo Object
     conn->request_name(cpu_info::cpuInfoObject);
-    sdbusplus::asio::object_server server =
+    [[maybe_unused]] sdbusplus::asio::object_server server =
         sdbusplus::asio::object_server(conn);
     sdbusplus::bus_t& bus = static_cast<sdbusplus::bus_t&>(*conn);
     sdbusplus::server::manager_t objManager(bus,
                                             "/xyz/openbmc_project/inventory");
 
     cpu_info::hostStateSetup(conn);
+    cpu_info::addHostStateCallback(
+        [conn](cpu_info::HostState, cpu_info::HostState) {
+            cpu_info::restartCpuTasks(conn);
+        });
 
 #if PECI_ENABLED
-    cpu_info::sst::init();
+    // Don't let queued or running PECI requests hold up the worker for a host
+    // that has powered off.
+    cpu_info::addHostStateCallback(
+        [](cpu_info::HostState, cpu_info::HostState newState) {
+            if (newState == cpu_info::HostState::off)
+            {
+                cpu_info::peci::getWorker().cancelAll();
+            }
+        });
+    cpu_info::peci::initReadiness();
+    cpu_info::sst::init(server);
+    cpu_info::peci::initMetrics(server);
 #endif
 
     // shared_ptr conn is global for the service
     // const reference of conn is passed to async calls
-    cpu_info::getCpuConfiguration(io, conn, server);
+    cpu_info::getCpuConfiguration(io, conn);
 
     io.run();
 
@@ -0,0 +1,189 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cpuinfo_tasks.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <iostream>
+
+namespace cpu_info
+{
+
+/** Blocking calls are short and rare, so a couple of threads suffice. */
+static constexpr size_t blockingThreads = 2;
+
+void TaskScope::cancel()
+{
+    isCancelled = true;
+    for (boost::asio::steady_timer* timer : timers)
+    {
+        timer->cancel();
+    }
+}
+
+void TaskScope::throwIfCancelled() const
+{
+    if (isCancelled)
+    {
+        throw boost::system::system_error(
+            boost::asio::error::operation_aborted);
+    }
+}
+
+boost::asio::awaitable<void>
+    TaskScope::sleep(std::chrono::steady_clock::duration duration)
+{
+    boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor,
+                                    duration);
+    co_await wait(timer);
+}
+
+boost::asio::awaitable<void> TaskScope::wait(boost::asio::steady_timer& timer)
+{
+    throwIfCancelled();
+
+    // Deregister the timer however the wait ends, including when the
+    // coroutine is destroyed while suspended.
+    struct Registration
+    {
+        std::list<boost::asio::steady_timer*>& timers;
+        std::list<boost::asio::steady_timer*>::iterator it;
+
+        ~Registration()
+        {
+            timers.erase(it);
+        }
+    } registration{timers, timers.insert(timers.end(), &timer)};
+
+    co_await timer.async_wait(boost::asio::use_awaitable);
+}
+
+boost::asio::awaitable<ResourceLimiter::Permit>
+    ResourceLimiter::acquire(std::shared_ptr<TaskScope> scope)
+{
+    scope->throwIfCancelled();
+    if (inUse < limit && waiters.empty())
+    {
+        inUse++;
+        co_return Permit(*this);
+    }
+
+    auto waiter = std::make_shared<Waiter>(
+        co_await boost::asio::this_coro::executor);
+    struct Queued
+    {
+        ResourceLimiter& limiter;
+        std::shared_ptr<Waiter> waiter;
+        bool taken = false;
+
+        ~Queued()
+        {
+            if (!waiter->granted)
+            {
+                limiter.waiters.remove(waiter);
+            }
+            else if (!taken)
+            {
+                // Granted, but the coroutine was destroyed before it resumed.
+                limiter.release();
+            }
+        }
+    } queued{*this, waiter};
+    waiters.push_back(waiter);
+
+    try
+    {
+        co_await scope->wait(waiter->timer);
+    }
+    catch (const boost::system::system_error&)
+    {
+        if (!waiter->granted)
+        {
+            throw;
+        }
+    }
+    if (!waiter->granted)
+    {
+        // The timer can't expire on its own.
+        throw boost::system::system_error(
+            boost::asio::error::operation_aborted);
+    }
+
+    // release() has already counted the permit as in use.
+    queued.taken = true;
+    Permit permit(*this);
+    if (scope->cancelled())
+    {
+        // Hands the permit on to the next waiter.
+        permit.reset();
+        throw boost::system::system_error(
+            boost::asio::error::operation_aborted);
+    }
+    co_return permit;
+}
+
+void ResourceLimiter::release()
+{
+    if (waiters.empty())
+    {
+        inUse--;
+        return;
+    }
+
+    // The permit is passed on directly, so inUse stays the same.
+    std::shared_ptr<Waiter> next = waiters.front();
+    waiters.pop_front();
+    next->granted = true;
+    next->timer.cancel();
+}
+
+void spawnTask(boost::asio::io_context& io, boost::asio::awaitable<void> task,
+               std::string name)
+{
+    boost::asio::co_spawn(
+        io, std::move(task), [name = std::move(name)](std::exception_ptr err) {
+            if (!err)
+            {
+                return;
+            }
+            try
+            {
+                std::rethrow_exception(err);
+            }
+            catch (const boost::system::system_error& e)
+            {
+                if (e.code() == boost::asio::error::operation_aborted)
+                {
+                    return;
+                }
+                std::cerr << name << " failed: " << e.what() << "\n";
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << name << " failed: " << e.what() << "\n";
+            }
+        });
+}
+
+boost::asio::thread_pool& blockingPool()
+{
+    static boost::asio::thread_pool pool(blockingThreads);
+    return pool;
+}
+
+} // namespace cpu_info
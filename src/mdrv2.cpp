@@ -551,6 +551,16 @@ void MDRV2::systemInfoUpdate()
             cpus[index]->infoUpdate(smbiosDir.dir[smbiosDirIndex].dataStorage,
                                     motherboardPath);
         }
+
+        auto enrichment = cpuEnrichment.find(index);
+        if (enrichment != cpuEnrichment.end())
+        {
+            cpus[index]->enrich(enrichment->second);
+        }
+        for (const auto& provider : enrichmentProviders)
+        {
+            provider->cpuUpdated(index);
+        }
     }
 
 #ifdef DIMM_DBUS
@@ -625,6 +635,15 @@ void MDRV2::systemInfoUpdate()
                                       smbiosFilePath);
 }
 
+void MDRV2::enrichCpu(uint8_t cpuNum, const CpuEnrichment& values)
+{
+    cpuEnrichment[cpuNum].merge(values);
+    if (cpuNum < cpus.size())
+    {
+        cpus[cpuNum]->enrich(values);
+    }
+}
+
 std::optional<size_t> MDRV2::getTotalCpuSlot()
 {
     uint8_t* dataIn = smbiosDir.dir[smbiosDirIndex].dataStorage;
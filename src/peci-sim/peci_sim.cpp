@@ -0,0 +1,668 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "peci_sim.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <thread>
+
+namespace peci_sim
+{
+
+// Completion codes returned by the simulated CPUs
+static constexpr uint8_t ccSuccess = PECI_DEV_CC_SUCCESS;
+static constexpr uint8_t ccUnavailResource = 0x82;
+static constexpr uint8_t ccInvalidRequest = 0x90;
+
+// OS Mailbox location and protocol, see PECIManager in sst_mailbox.cpp
+static constexpr uint8_t mbDevice = 30;
+static constexpr uint8_t mbFunction = 1;
+static constexpr uint16_t mbDataReg = 0xA0;
+static constexpr uint16_t mbInterfaceReg = 0xA4;
+static constexpr uint32_t mbBusyBit = 1u << 31;
+static constexpr uint8_t mbCommandSST = 0x7F;
+static constexpr uint8_t mbStatusSuccess = 0x0;
+static constexpr uint8_t mbStatusInvalidCommand = 0x1;
+static constexpr uint8_t mbStatusIllegalData = 0x16;
+
+// TPMI location and layout, see SSTTPMI in sst_tpmi.cpp. The PFS lists an
+// uncore entry and the SST entry, with one 1 KiB SST instance per power domain.
+static constexpr uint8_t tpmiDevice = 3;
+static constexpr uint8_t tpmiFunction = 1;
+static constexpr uint8_t tpmiBar = 0;
+static constexpr uint64_t tpmiIdUncore = 0x2;
+static constexpr uint64_t tpmiIdSST = 0x5;
+static constexpr uint64_t sstInstanceSize = 0x400;
+static constexpr uint64_t sstInstanceBase = 0x400;
+static constexpr uint64_t sstPPOffset = 0x20;
+static constexpr uint64_t sstMaxLevels = 5;
+static constexpr uint64_t sstLevelInfoSize = 16;
+static constexpr uint64_t sstBFInfoOffset = 12;
+
+// Package config indexes
+static constexpr uint8_t pcsWakeOnPECI = 5;
+static constexpr uint8_t pcsPPIN = 19;
+
+/** The bus lock serializes all transactions, like a real PECI bus. */
+static std::mutex busMutex;
+static std::map<uint8_t, SimCPU> cpus;
+static std::map<uint8_t, std::map<std::string, uint64_t>> stats;
+
+void reset()
+{
+    std::lock_guard lock(busMutex);
+    cpus.clear();
+    stats.clear();
+}
+
+void addCPU(uint8_t address, SimCPU cpu)
+{
+    std::lock_guard lock(busMutex);
+    cpus.insert_or_assign(address, std::move(cpu));
+}
+
+void withCPU(uint8_t address, const std::function<void(SimCPU&)>& fn)
+{
+    std::lock_guard lock(busMutex);
+    fn(cpus.at(address));
+}
+
+std::map<std::string, uint64_t> transactions(uint8_t address)
+{
+    std::lock_guard lock(busMutex);
+    return stats[address];
+}
+
+uint64_t totalTransactions(uint8_t address)
+{
+    std::map<std::string, uint64_t> counts = transactions(address);
+    return std::accumulate(
+        counts.begin(), counts.end(), uint64_t{0},
+        [](uint64_t sum, const auto& count) { return sum + count.second; });
+}
+
+static std::vector<unsigned int> coreRange(unsigned int first,
+                                           unsigned int count)
+{
+    std::vector<unsigned int> cores(count);
+    std::iota(cores.begin(), cores.end(), first);
+    return cores;
+}
+
+SimCPU makeSSTCPU(uint64_t ppin)
+{
+    SimCPU cpu;
+    cpu.model = sapphireRapids;
+    cpu.stepping = 8;
+    cpu.ppin = ppin;
+
+    SimLevel base;
+    base.tdp = 350;
+    base.tdpRatio = 20;
+    base.cores = coreRange(0, 56);
+    base.p0Ratio = 38;
+    base.p1Ratio = 20;
+    base.pnRatio = 8;
+    base.pmRatio = 8;
+    base.tProchot = 100;
+    base.bfSupported = true;
+    base.tfSupported = true;
+    base.bfHighPriorityCores = coreRange(0, 16);
+    base.p1HiRatio = 26;
+    base.p1LoRatio = 18;
+    base.turboRatioLimits = 0x1C1E20222426282AULL;
+    cpu.levels[0] = base;
+
+    SimLevel level3 = base;
+    level3.tdp = 300;
+    level3.cores = coreRange(0, 48);
+    level3.p1Ratio = 21;
+    level3.bfHighPriorityCores = coreRange(0, 12);
+    cpu.levels[3] = level3;
+
+    SimLevel level4 = base;
+    level4.tdp = 270;
+    level4.cores = coreRange(0, 32);
+    level4.p1Ratio = 23;
+    level4.bfSupported = false;
+    level4.bfHighPriorityCores.clear();
+    cpu.levels[4] = level4;
+
+    // Turbo Ratio Limit Cores MSR: bucket sizes
+    cpu.msrs[0x1AE] = 0x3830282018100C08ULL;
+    // MSR_CORE_THREAD_COUNT: 56 cores, 112 threads
+    cpu.msrs[0x35] = (56 << 16) | 112;
+    return cpu;
+}
+
+SimCPU makeTPMICPU(uint64_t ppin)
+{
+    SimCPU cpu = makeSSTCPU(ppin);
+    cpu.model = graniteRapids;
+    cpu.stepping = 1;
+    cpu.powerDomains = 2;
+    cpu.msrs.clear();
+
+    // 60 cores on each compute die
+    auto dieCores = [](unsigned int count) {
+        std::vector<unsigned int> cores = coreRange(0, count);
+        std::vector<unsigned int> die1 = coreRange(64, count);
+        cores.insert(cores.end(), die1.begin(), die1.end());
+        return cores;
+    };
+    cpu.levels[0].cores = dieCores(60);
+    cpu.levels[0].bfHighPriorityCores = dieCores(8);
+    cpu.levels[3].cores = dieCores(48);
+    cpu.levels[3].bfHighPriorityCores = dieCores(6);
+    cpu.levels[4].cores = dieCores(32);
+    for (auto& [levelNum, level] : cpu.levels)
+    {
+        level.turboBucketCores = 0x3830282018100C08ULL;
+    }
+    return cpu;
+}
+
+/**
+ * Common handling of all transactions: count it, apply the latency and any
+ * injected fault, then run the command itself.
+ */
+template <typename Fn>
+static EPECIStatus transaction(uint8_t address, const char* command,
+                               uint8_t* cc, Fn&& fn)
+{
+    std::lock_guard lock(busMutex);
+    *cc = 0;
+    stats[address][command]++;
+
+    auto it = cpus.find(address);
+    if (it == cpus.end())
+    {
+        return PECI_CC_CPU_NOT_PRESENT;
+    }
+    SimCPU& cpu = it->second;
+
+    if (cpu.latency.count() > 0)
+    {
+        std::this_thread::sleep_for(cpu.latency);
+    }
+
+    Fault fault = cpu.faultHook ? cpu.faultHook(command) : Fault::none;
+    switch (fault)
+    {
+        case Fault::none:
+            break;
+        case Fault::timeout:
+            return PECI_CC_TIMEOUT;
+        case Fault::sleeping:
+            *cc = ccUnavailResource;
+            return PECI_CC_DRIVER_ERR;
+        case Fault::driverError:
+            return PECI_CC_DRIVER_ERR;
+    }
+    return fn(cpu);
+}
+
+static bool maskWordValid(const SimCPU& cpu, unsigned int word)
+{
+    return word < cpu.coreMaskWords || cpu.coreMaskIndexWraps;
+}
+
+static uint32_t maskWord(const std::vector<unsigned int>& cores,
+                         unsigned int word)
+{
+    uint32_t mask = 0;
+    for (unsigned int core : cores)
+    {
+        if (core / 32 == word)
+        {
+            mask |= 1u << (core % 32);
+        }
+    }
+    return mask;
+}
+
+/**
+ * Run an SST command on the OS Mailbox.
+ *
+ * @return  (mailbox status, response data)
+ */
+static std::pair<uint8_t, uint32_t> runMailboxCommand(SimCPU& cpu,
+                                                      uint8_t subCommand,
+                                                      uint32_t param)
+{
+    unsigned int levelNum = param & 0xFF;
+    unsigned int word = (param >> 8) & 0xFF;
+    auto levelIt = cpu.levels.find(levelNum);
+    const SimLevel* level =
+        levelIt == cpu.levels.end() ? nullptr : &levelIt->second;
+    const std::pair<uint8_t, uint32_t> illegal{mbStatusIllegalData, 0};
+
+    auto ok = [](uint32_t data) {
+        return std::make_pair(mbStatusSuccess, data);
+    };
+
+    switch (subCommand)
+    {
+        case 0x0: // GetLevelsInfo
+        {
+            unsigned int maxLevel =
+                cpu.levels.empty() ? 0 : cpu.levels.rbegin()->first;
+            return ok((cpu.ppEnabled ? 1u << 31 : 0) |
+                      (cpu.ppLocked ? 1u << 24 : 0) |
+                      (cpu.currentLevel << 16) | (maxLevel << 8) | 1);
+        }
+        case 0x1: // GetConfigTdpControl
+            if (!level)
+            {
+                return illegal;
+            }
+            return ok((cpu.bfEnabled ? 1u << 17 : 0) |
+                      (cpu.tfEnabled ? 1u << 16 : 0) |
+                      (level->bfSupported ? 1u << 1 : 0) |
+                      (level->tfSupported ? 1u : 0));
+        case 0x2: // SetConfigTdpControl
+        {
+            uint8_t control = (param >> 16) & 0xFF;
+            cpu.bfEnabled = control & 0x2;
+            cpu.tfEnabled = control & 0x1;
+            return ok(0);
+        }
+        case 0x3: // GetTdpInfo
+            if (!level)
+            {
+                return illegal;
+            }
+            return ok((level->tdpRatio << 16) | (level->tdp & 0x7FFF));
+        case 0x5: // GetTjmaxInfo
+            if (!level)
+            {
+                return illegal;
+            }
+            return ok(level->tProchot & 0xFF);
+        case 0x6: // GetCoreMask
+            if (!level || !maskWordValid(cpu, word))
+            {
+                return illegal;
+            }
+            return ok(maskWord(level->cores, word % cpu.coreMaskWords));
+        case 0x7: // GetTurboLimitRatios
+            if (!level || word > 1)
+            {
+                return illegal;
+            }
+            return ok(static_cast<uint32_t>(level->turboRatioLimits >>
+                                            (32 * word)));
+        case 0x8: // SetLevel
+            if (!level)
+            {
+                return illegal;
+            }
+            cpu.currentLevel = levelNum;
+            return ok(0);
+        case 0xC: // GetRatioInfo
+            if (!level)
+            {
+                return illegal;
+            }
+            return ok((level->pmRatio << 24) | (level->pnRatio << 16) |
+                      (level->p1Ratio << 8) | level->p0Ratio);
+        case 0x20: // PbfGetCoreMaskInfo
+            if (!level || !level->bfSupported || !maskWordValid(cpu, word))
+            {
+                return illegal;
+            }
+            return ok(
+                maskWord(level->bfHighPriorityCores, word % cpu.coreMaskWords));
+        case 0x21: // PbfGetP1HiP1LoInfo
+            if (!level || !level->bfSupported)
+            {
+                return illegal;
+            }
+            return ok((level->p1HiRatio << 8) | level->p1LoRatio);
+        default:
+            return {mbStatusInvalidCommand, 0};
+    }
+}
+
+static bool hasTPMI(const SimCPU& cpu)
+{
+    switch (cpu.model)
+    {
+        case graniteRapids:
+        case graniteRapidsD:
+        case sierraForest:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static uint64_t coreMask(const std::vector<unsigned int>& cores,
+                         unsigned int domain)
+{
+    uint64_t mask = 0;
+    for (unsigned int core : cores)
+    {
+        if (core / 64 == domain)
+        {
+            mask |= uint64_t{1} << (core % 64);
+        }
+    }
+    return mask;
+}
+
+/**
+ * Return the 64-bit TPMI register at an offset in the TPMI BAR. Registers of an
+ * SST instance which aren't modelled read as 0, and anything outside of them
+ * as all ones.
+ */
+static uint64_t tpmiRegister(const SimCPU& cpu, uint64_t offset)
+{
+    constexpr uint64_t unimplemented = ~uint64_t{0};
+
+    if (offset < sstInstanceBase)
+    {
+        switch (offset / 8)
+        {
+            case 0:
+                // 16 dword entry at 16 KiB, never read
+                return tpmiIdUncore | (1 << 8) | (16 << 16) |
+                       (uint64_t{16} << 32);
+            case 1:
+                return tpmiIdSST | (cpu.powerDomains << 8) |
+                       ((sstInstanceSize / 4) << 16) |
+                       ((sstInstanceBase / 1024) << 32);
+            default:
+                return unimplemented;
+        }
+    }
+
+    uint64_t domain = (offset - sstInstanceBase) / sstInstanceSize;
+    if (domain >= cpu.powerDomains)
+    {
+        return unimplemented;
+    }
+    uint64_t reg = (offset - sstInstanceBase) % sstInstanceSize / 8;
+    uint64_t features =
+        (cpu.bfEnabled ? 1 << 0 : 0) | (cpu.tfEnabled ? 1 << 1 : 0);
+
+    if (reg == 0)
+    {
+        // Version 1 with CP and SST-PP, PP registers at sstPPOffset
+        return 1 | (0x3 << 8) | (2 << 16) | ((sstPPOffset / 8) << 24);
+    }
+    if (reg < sstPPOffset / 8)
+    {
+        return 0;
+    }
+
+    reg -= sstPPOffset / 8;
+    switch (reg)
+    {
+        case 0: // PP_HEADER
+        {
+            uint64_t levelMask = 0;
+            for (const auto& [levelNum, level] : cpu.levels)
+            {
+                if (cpu.ppEnabled && levelNum < sstMaxLevels)
+                {
+                    levelMask |= 1 << levelNum;
+                }
+            }
+            return 1 | (levelMask << 8);
+        }
+        case 1: // PP_OFFSET_0: PP info at 0, BF info, TF info after it
+            return (sstBFInfoOffset << 8) | ((sstBFInfoOffset + 2) << 16);
+        case 2: // PP_OFFSET_1: level n at 8 + 16 * n
+        {
+            uint64_t offsets = 0;
+            for (uint64_t level = 0; level < sstMaxLevels; level++)
+            {
+                offsets |= (8 + level * sstLevelInfoSize) << (level * 8);
+            }
+            return offsets;
+        }
+        case 3: // PP_CONTROL
+        case 4: // PP_STATUS
+            return cpu.currentLevel | (features << 8);
+        default:
+            break;
+    }
+    if (reg < 8)
+    {
+        return 0;
+    }
+
+    uint64_t levelNum = (reg - 8) / sstLevelInfoSize;
+    auto levelIt = cpu.levels.find(levelNum);
+    if (levelNum >= sstMaxLevels || levelIt == cpu.levels.end())
+    {
+        return 0;
+    }
+    const SimLevel& level = levelIt->second;
+    switch ((reg - 8) % sstLevelInfoSize)
+    {
+        case 0:
+            return (level.bfSupported ? 1 : 0) | (level.tfSupported ? 2 : 0);
+        case 1:
+            return (level.tdp & 0x7FFF) | ((level.tProchot & 0xFF) << 15);
+        case 2:
+            return coreMask(level.cores, domain);
+        case 4:
+            return level.p0Ratio | (level.p1Ratio << 8) |
+                   (level.pnRatio << 16) | (level.pmRatio << 24);
+        case 10:
+            return level.turboRatioLimits;
+        case 11:
+            return level.turboBucketCores;
+        case sstBFInfoOffset:
+            return level.p1HiRatio | (level.p1LoRatio << 8);
+        case sstBFInfoOffset + 1:
+            return coreMask(level.bfHighPriorityCores, domain);
+        default:
+            return 0;
+    }
+}
+
+static bool isMailbox(uint8_t device, uint8_t function)
+{
+    return device == mbDevice && function == mbFunction;
+}
+
+} // namespace peci_sim
+
+using namespace peci_sim;
+
+extern "C"
+{
+
+EPECIStatus peci_GetCPUID(const uint8_t clientAddr, CPUModel* cpuModel,
+                          uint8_t* stepping, uint8_t* cc)
+{
+    return transaction(clientAddr, "GetCPUID", cc, [&](SimCPU& cpu) {
+        *cpuModel = cpu.model;
+        *stepping = cpu.stepping;
+        *cc = ccSuccess;
+        return PECI_CC_SUCCESS;
+    });
+}
+
+EPECIStatus peci_RdPkgConfig(uint8_t target, uint8_t u8Index,
+                             uint16_t u16Value, uint8_t u8ReadLen,
+                             uint8_t* pPkgConfig, uint8_t* cc)
+{
+    return transaction(target, "RdPkgConfig", cc, [&](SimCPU& cpu) {
+        std::optional<uint32_t> value;
+        if (u8Index == pcsPPIN && (u16Value == 1 || u16Value == 2))
+        {
+            value = static_cast<uint32_t>(cpu.ppin >> (u16Value == 2 ? 32 : 0));
+        }
+        else if (auto it = cpu.pkgConfig.find({u8Index, u16Value});
+                 it != cpu.pkgConfig.end())
+        {
+            value = it->second;
+        }
+        if (!value)
+        {
+            *cc = ccInvalidRequest;
+            return PECI_CC_SUCCESS;
+        }
+        std::memcpy(pPkgConfig, &*value,
+                    std::min<size_t>(u8ReadLen, sizeof(*value)));
+        *cc = ccSuccess;
+        return PECI_CC_SUCCESS;
+    });
+}
+
+EPECIStatus peci_WrPkgConfig(uint8_t target, uint8_t u8Index,
+                             uint16_t u16Param, uint32_t u32Value,
+                             uint8_t /* u8WriteLen */, uint8_t* cc)
+{
+    return transaction(target, "WrPkgConfig", cc, [&](SimCPU& cpu) {
+        if (u8Index == pcsWakeOnPECI)
+        {
+            cpu.wakeOnPECI = u16Param & 1;
+        }
+        else
+        {
+            cpu.pkgConfig[{u8Index, u16Param}] = u32Value;
+        }
+        *cc = ccSuccess;
+        return PECI_CC_SUCCESS;
+    });
+}
+
+EPECIStatus peci_RdIAMSR(uint8_t target, uint8_t /* threadID */,
+                         uint16_t MSRAddress, uint64_t* u64MsrVal, uint8_t* cc)
+{
+    return transaction(target, "RdIAMSR", cc, [&](SimCPU& cpu) {
+        auto it = cpu.msrs.find(MSRAddress);
+        if (it == cpu.msrs.end())
+        {
+            *cc = ccInvalidRequest;
+            return PECI_CC_SUCCESS;
+        }
+        *u64MsrVal = it->second;
+        *cc = ccSuccess;
+        return PECI_CC_SUCCESS;
+    });
+}
+
+EPECIStatus peci_RdEndPointConfigPciLocal(
+    uint8_t target, uint8_t /* u8Seg */, uint8_t /* u8Bus */, uint8_t u8Device,
+    uint8_t u8Fcn, uint16_t u16Reg, uint8_t u8ReadLen, uint8_t* pPCIData,
+    uint8_t* cc)
+{
+    auto read = [&](SimCPU& cpu) {
+        if (cpu.asleep && !cpu.wakeOnPECI)
+        {
+            *cc = ccUnavailResource;
+            return PECI_CC_DRIVER_ERR;
+        }
+        if (!isMailbox(u8Device, u8Fcn) ||
+            (u16Reg != mbDataReg && u16Reg != mbInterfaceReg))
+        {
+            *cc = ccInvalidRequest;
+            return PECI_CC_SUCCESS;
+        }
+
+        uint32_t value = cpu.mbData;
+        if (u16Reg == mbInterfaceReg)
+        {
+            value = cpu.mbInterface;
+            if (std::chrono::steady_clock::now() < cpu.mbBusyUntil)
+            {
+                value |= mbBusyBit;
+            }
+        }
+        std::memcpy(pPCIData, &value,
+                    std::min<size_t>(u8ReadLen, sizeof(value)));
+        *cc = ccSuccess;
+        return PECI_CC_SUCCESS;
+    };
+    return transaction(target, "RdEndPointConfigPciLocal", cc, read);
+}
+
+EPECIStatus peci_WrEndPointPCIConfigLocal(
+    uint8_t target, uint8_t /* u8Seg */, uint8_t /* u8Bus */, uint8_t u8Device,
+    uint8_t u8Fcn, uint16_t u16Reg, uint8_t /* DataLen */, uint32_t DataVal,
+    uint8_t* cc)
+{
+    auto write = [&](SimCPU& cpu) {
+        if (cpu.asleep && !cpu.wakeOnPECI)
+        {
+            *cc = ccUnavailResource;
+            return PECI_CC_TIMEOUT;
+        }
+        if (!isMailbox(u8Device, u8Fcn) ||
+            (u16Reg != mbDataReg && u16Reg != mbInterfaceReg))
+        {
+            *cc = ccInvalidRequest;
+            return PECI_CC_SUCCESS;
+        }
+
+        *cc = ccSuccess;
+        auto now = std::chrono::steady_clock::now();
+        if (u16Reg == mbDataReg)
+        {
+            cpu.mbData = DataVal;
+            return PECI_CC_SUCCESS;
+        }
+        // Starting a command while the mailbox is busy is ignored.
+        if ((DataVal & mbBusyBit) == 0 || now < cpu.mbBusyUntil)
+        {
+            return PECI_CC_SUCCESS;
+        }
+
+        uint8_t command = DataVal & 0xFF;
+        uint8_t subCommand = (DataVal >> 8) & 0xFF;
+        auto [status, data] =
+            command == mbCommandSST
+                ? runMailboxCommand(cpu, subCommand, cpu.mbData)
+                : std::make_pair(mbStatusInvalidCommand, uint32_t{0});
+        cpu.mbData = data;
+        cpu.mbInterface = status;
+        cpu.mbBusyUntil = now + cpu.mailboxBusyTime;
+        return PECI_CC_SUCCESS;
+    };
+    return transaction(target, "WrEndPointPCIConfigLocal", cc, write);
+}
+
+EPECIStatus peci_RdEndPointConfigMmio(
+    uint8_t target, uint8_t /* u8Seg */, uint8_t /* u8Bus */, uint8_t u8Device,
+    uint8_t u8Fcn, uint8_t u8Bar, uint8_t /* u8AddrType */, uint64_t u64Offset,
+    uint8_t u8ReadLen, uint8_t* pMmioData, uint8_t* cc)
+{
+    return transaction(target, "RdEndPointConfigMmio", cc, [&](SimCPU& cpu) {
+        if (!hasTPMI(cpu) || u8Device != tpmiDevice || u8Fcn != tpmiFunction ||
+            u8Bar != tpmiBar || (u8ReadLen != 4 && u8ReadLen != 8) ||
+            u64Offset % u8ReadLen != 0)
+        {
+            *cc = ccInvalidRequest;
+            return PECI_CC_SUCCESS;
+        }
+
+        uint64_t value = tpmiRegister(cpu, u64Offset & ~uint64_t{7}) >>
+                         (8 * (u64Offset & 7));
+        std::memcpy(pMmioData, &value, u8ReadLen);
+        *cc = ccSuccess;
+        return PECI_CC_SUCCESS;
+    });
+}
+
+} // extern "C"
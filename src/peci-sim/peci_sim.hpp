@@ -0,0 +1,166 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <peci.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Link-time replacement for libpeci, for tests and benchmarks which exercise
+ * the cpuinfoapp PECI code without hardware.
+ *
+ * Each simulated CPU is a scriptable model: SST-PP levels served through the
+ * OS Mailbox or TPMI depending on the CPU model, package config (PCS) values,
+ * MSRs, a per-transaction latency and a fault injection hook. All transactions
+ * are serialized like on a real PECI bus, and counted per CPU and command type.
+ */
+namespace peci_sim
+{
+
+/** Fault to inject into a single transaction. */
+enum class Fault
+{
+    none,
+    /** Transaction times out. */
+    timeout,
+    /** Package is asleep, completion code 0x82. */
+    sleeping,
+    /** Driver-level error. */
+    driverError,
+};
+
+/** One SST-PP config level, as reported through the OS Mailbox. */
+struct SimLevel
+{
+    unsigned int tdp = 0;
+    unsigned int tdpRatio = 0;
+    /** Enabled cores, as core indexes. */
+    std::vector<unsigned int> cores;
+    unsigned int p0Ratio = 0;
+    unsigned int p1Ratio = 0;
+    unsigned int pnRatio = 0;
+    unsigned int pmRatio = 0;
+    unsigned int tProchot = 0;
+    bool bfSupported = false;
+    bool tfSupported = false;
+    /** SST-BF high priority cores, as core indexes. */
+    std::vector<unsigned int> bfHighPriorityCores;
+    unsigned int p1HiRatio = 0;
+    unsigned int p1LoRatio = 0;
+    /** 8 one-byte turbo ratio limits, lowest bucket in the low byte. */
+    uint64_t turboRatioLimits = 0;
+    /**
+     * 8 one-byte turbo bucket core counts, lowest bucket in the low byte. Only
+     * reported through TPMI, the OS Mailbox CPUs report them through MSR
+     * 0x1AE instead.
+     */
+    uint64_t turboBucketCores = 0;
+};
+
+/** State and behavior of one simulated CPU. */
+struct SimCPU
+{
+    CPUModel model = sapphireRapids;
+    uint8_t stepping = 0;
+    uint64_t ppin = 0;
+
+    /** SST-PP config levels, keyed by level number. */
+    std::map<unsigned int, SimLevel> levels;
+    bool ppEnabled = true;
+    /** GetLevelsInfo lock bit, set when the BIOS locked the SST-PP config. */
+    bool ppLocked = false;
+    unsigned int currentLevel = 0;
+    bool bfEnabled = false;
+    bool tfEnabled = false;
+    /** Number of 32-bit words the mailbox returns for core masks. */
+    unsigned int coreMaskWords = 2;
+    /**
+     * Whether core mask word indexes past coreMaskWords wrap around, like in
+     * pcode which masks the index, instead of being rejected.
+     */
+    bool coreMaskIndexWraps = false;
+    /**
+     * Number of power domains with an SST instance in TPMI, for models which
+     * report SST through TPMI rather than the OS Mailbox. Core n belongs to
+     * domain n / 64.
+     */
+    unsigned int powerDomains = 1;
+
+    /** Package config values keyed by (index, parameter). */
+    std::map<std::pair<uint8_t, uint16_t>, uint32_t> pkgConfig;
+    /** MSR values keyed by address. */
+    std::map<uint16_t, uint64_t> msrs;
+
+    /** Time each PECI transaction occupies the bus. */
+    std::chrono::microseconds latency{0};
+    /** Time the mailbox reports RUN_BUSY after a command is started. */
+    std::chrono::microseconds mailboxBusyTime{0};
+    /**
+     * Whether the package is in a deep package C-state. PCI config accesses
+     * fail with completion code 0x82 until Wake-On-PECI is set.
+     */
+    bool asleep = false;
+    /**
+     * Called for every transaction with the command name, to inject faults.
+     */
+    std::function<Fault(const std::string& command)> faultHook;
+
+    // Simulator state, not meant to be scripted.
+    bool wakeOnPECI = false;
+    uint32_t mbData = 0;
+    uint32_t mbInterface = 0;
+    std::chrono::steady_clock::time_point mbBusyUntil{};
+};
+
+/** Remove all simulated CPUs and reset the statistics. */
+void reset();
+
+/**
+ * Add a simulated CPU, replacing any CPU at the same address.
+ *
+ * @param[in]   address PECI address of the CPU.
+ * @param[in]   cpu     CPU model and initial state.
+ */
+void addCPU(uint8_t address, SimCPU cpu);
+
+/**
+ * Run a function with exclusive access to a simulated CPU, e.g. to inspect or
+ * change its state between transactions.
+ */
+void withCPU(uint8_t address, const std::function<void(SimCPU&)>& fn);
+
+/** Return a Sapphire Rapids CPU with a typical set of SST-PP levels. */
+SimCPU makeSSTCPU(uint64_t ppin = 0);
+
+/**
+ * Return a Granite Rapids CPU with two power domains and a typical set of
+ * SST-PP levels, served through TPMI.
+ */
+SimCPU makeTPMICPU(uint64_t ppin = 0);
+
+/** Transactions sent to one CPU, keyed by command name. */
+std::map<std::string, uint64_t> transactions(uint8_t address);
+
+/** Total transactions sent to one CPU. */
+uint64_t totalTransactions(uint8_t address);
+
+} // namespace peci_sim
@@ -0,0 +1,111 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * Run full SST discovery against 1-8 simulated sockets, the same way
+ * cpuinfoapp does (one PECI worker job per socket), and report the PECI
+ * transactions and wall time per socket. Discovery only reads the current
+ * level, so the same job then reads the pending levels like the background
+ * pass does, to measure every level as before.
+ *
+ * Usage: sst_discovery_benchmark [latency-us [mailbox-busy-us]]
+ */
+
+#include "peci_sim.hpp"
+#include "peci_worker.hpp"
+#include "sst_discovery.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace cpu_info;
+
+int main(int argc, char** argv)
+{
+    std::chrono::microseconds latency{argc > 1 ? std::atoi(argv[1]) : 500};
+    std::chrono::microseconds busyTime{argc > 2 ? std::atoi(argv[2]) : 200};
+
+    std::printf("PECI latency %lldus, mailbox busy %lldus\n",
+                static_cast<long long>(latency.count()),
+                static_cast<long long>(busyTime.count()));
+    std::printf("%8s %12s %16s %16s\n", "sockets", "wall (ms)",
+                "ms per socket", "PECI per socket");
+
+    for (uint8_t sockets = 1; sockets <= 8; sockets++)
+    {
+        peci_sim::reset();
+        for (uint8_t i = 0; i < sockets; i++)
+        {
+            peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+            cpu.latency = latency;
+            cpu.mailboxBusyTime = busyTime;
+            peci_sim::addCPU(MIN_CLIENT_ADDR + i, std::move(cpu));
+        }
+
+        boost::asio::io_context ioc;
+        peci::Worker worker(ioc, peci::workerThreads);
+        unsigned int discovered = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint8_t i = 0; i < sockets; i++)
+        {
+            worker.post(
+                [address = static_cast<uint8_t>(MIN_CLIENT_ADDR + i)](
+                    std::stop_token stop) {
+                    sst::SocketDiscovery result =
+                        sst::discoverCPU(address, std::move(stop));
+                    for (unsigned int level : result.cpu.pendingLevels)
+                    {
+                        result.cpu.levels.push_back(
+                            sst::discoverLevel(*result.cpu.sst, level));
+                    }
+                    result.cpu.pendingLevels.clear();
+                    result.cpu.sst.reset();
+                    return result;
+                },
+                [&discovered](std::exception_ptr err,
+                              sst::SocketDiscovery result) {
+                    if (!err && result.status == sst::SocketStatus::discovered)
+                    {
+                        discovered++;
+                    }
+                });
+        }
+        ioc.run();
+        auto wallTime = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start);
+
+        if (discovered != sockets)
+        {
+            std::fprintf(stderr, "Only discovered %u of %u sockets\n",
+                         discovered, static_cast<unsigned>(sockets));
+            return EXIT_FAILURE;
+        }
+
+        uint64_t transactions = 0;
+        for (uint8_t i = 0; i < sockets; i++)
+        {
+            transactions += peci_sim::totalTransactions(MIN_CLIENT_ADDR + i);
+        }
+        std::printf("%8u %12.1f %16.1f %16.1f\n",
+                    static_cast<unsigned>(sockets), wallTime.count(),
+                    wallTime.count() / sockets,
+                    static_cast<double>(transactions) / sockets);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+#include "cpuinfo_cache.hpp"
+#include "peci_sim.hpp"
+#include "sst_discovery.hpp"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <stop_token>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace cpu_info::cache
+{
+
+static constexpr uint8_t cpu0 = MIN_CLIENT_ADDR;
+static constexpr uint64_t ppin1 = 0x0123456789ABCDEF;
+static constexpr uint64_t ppin2 = 0xFEDCBA9876543210;
+
+class CPUInfoCacheTest : public ::testing::Test
+{
+  protected:
+    std::filesystem::path dir = std::filesystem::temp_directory_path() /
+                                ("cpuinfo-cache-" + std::to_string(getpid()));
+
+    void SetUp() override
+    {
+        peci_sim::reset();
+        std::filesystem::remove_all(dir);
+        setCacheDir(dir);
+    }
+
+    void TearDown() override
+    {
+        setCacheDir(defaultCacheDir);
+        std::filesystem::remove_all(dir);
+    }
+};
+
+TEST_F(CPUInfoCacheTest, CachesPPIN)
+{
+    // Verify the PPIN read from a CPU is cached, and kept while the same CPU
+    // is installed.
+
+    peci_sim::addCPU(cpu0, peci_sim::makeSSTCPU(ppin1));
+
+    EXPECT_FALSE(loadPPIN(cpu0));
+    EXPECT_EQ(verifyPPIN(cpu0), ppin1);
+    EXPECT_EQ(loadPPIN(cpu0), ppin1);
+
+    EXPECT_EQ(verifyPPIN(cpu0), ppin1);
+    EXPECT_EQ(loadPPIN(cpu0), ppin1);
+}
+
+TEST_F(CPUInfoCacheTest, ReplacesChangedPPIN)
+{
+    // Verify the cached PPIN is replaced when another CPU is installed.
+
+    peci_sim::addCPU(cpu0, peci_sim::makeSSTCPU(ppin1));
+    ASSERT_EQ(verifyPPIN(cpu0), ppin1);
+
+    peci_sim::addCPU(cpu0, peci_sim::makeTPMICPU(ppin2));
+    EXPECT_EQ(verifyPPIN(cpu0), ppin2);
+    EXPECT_EQ(loadPPIN(cpu0), ppin2);
+}
+
+TEST_F(CPUInfoCacheTest, DropsPPINWhenZero)
+{
+    // Verify the cached PPIN is removed when the installed CPU reports none,
+    // and the socket's other cache sections are kept.
+
+    peci_sim::addCPU(cpu0, peci_sim::makeSSTCPU(ppin1));
+    ASSERT_EQ(verifyPPIN(cpu0), ppin1);
+    store(cpu0, "other", 42);
+
+    peci_sim::addCPU(cpu0, peci_sim::makeSSTCPU(0));
+    EXPECT_EQ(verifyPPIN(cpu0), 0U);
+    EXPECT_FALSE(loadPPIN(cpu0));
+    EXPECT_EQ(load(cpu0, "other"), nlohmann::json(42));
+}
+
+TEST_F(CPUInfoCacheTest, KeepsPPINWhenAbsent)
+{
+    // Verify the cached PPIN is kept while the CPU doesn't respond.
+
+    peci_sim::addCPU(cpu0, peci_sim::makeSSTCPU(ppin1));
+    ASSERT_EQ(verifyPPIN(cpu0), ppin1);
+
+    peci_sim::reset();
+    EXPECT_FALSE(verifyPPIN(cpu0));
+    EXPECT_EQ(loadPPIN(cpu0), ppin1);
+}
+
+TEST_F(CPUInfoCacheTest, KeepsPPINWhenReadFails)
+{
+    // Verify a PPIN read which fails after GetCPUID succeeded leaves the
+    // cached PPIN alone, rather than being taken for a CPU without one or
+    // publishing half of the PPIN.
+
+    peci_sim::addCPU(cpu0, peci_sim::makeSSTCPU(ppin1));
+    ASSERT_EQ(verifyPPIN(cpu0), ppin1);
+
+    // Fail the n-th PPIN half read from now on.
+    auto failRead = [](unsigned int failedRead) {
+        peci_sim::withCPU(cpu0, [failedRead](peci_sim::SimCPU& cpu) {
+            cpu.faultHook = [failedRead,
+                             reads = 0U](const std::string& command) mutable {
+                if (command == "RdPkgConfig" && ++reads == failedRead)
+                {
+                    return peci_sim::Fault::sleeping;
+                }
+                return peci_sim::Fault::none;
+            };
+        });
+    };
+
+    for (unsigned int failedRead : {1U, 2U})
+    {
+        failRead(failedRead);
+        EXPECT_FALSE(readPPIN(cpu0, sapphireRapids));
+        failRead(failedRead);
+        EXPECT_FALSE(verifyPPIN(cpu0));
+        EXPECT_EQ(loadPPIN(cpu0), ppin1);
+    }
+}
+
+TEST_F(CPUInfoCacheTest, DiscoveryFailsWithoutPPIN)
+{
+    // Verify SST discovery doesn't key its level cache with a PPIN it
+    // couldn't read.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU(ppin1);
+    cpu.faultHook = [](const std::string& command) {
+        return command == "RdPkgConfig" ? peci_sim::Fault::driverError
+                                        : peci_sim::Fault::none;
+    };
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    EXPECT_THROW(sst::discoverCPU(cpu0, std::stop_token()), sst::PECIError);
+}
+
+TEST_F(CPUInfoCacheTest, DiscoveryReadsIdentity)
+{
+    // Verify SST discovery reports the identity, including PPIN, which keys
+    // its level cache.
+
+    peci_sim::addCPU(cpu0, peci_sim::makeSSTCPU(ppin1));
+
+    sst::SocketDiscovery result = sst::discoverCPU(cpu0, std::stop_token());
+    ASSERT_EQ(result.status, sst::SocketStatus::discovered);
+    EXPECT_EQ(result.cpu.identity, (CPUIdentity{sapphireRapids, 8, ppin1}));
+}
+
+} // namespace cpu_info::cache
@@ -0,0 +1,85 @@
+#include "cpuinfo_utils.hpp"
+#include "peci_readiness.hpp"
+#include "peci_sim.hpp"
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+namespace cpu_info::peci
+{
+
+using namespace std::chrono_literals;
+
+static constexpr uint8_t cpu0 = MIN_CLIENT_ADDR;
+
+class PECIReadinessTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        peci_sim::reset();
+        hostState = HostState::postComplete;
+    }
+
+    void TearDown() override
+    {
+        hostState = HostState::off;
+    }
+
+    /**
+     * Wait for the CPU to be reported ready, and return how long it took.
+     *
+     * @param[in]   retry   Use retryWhenReady instead of whenReady.
+     */
+    std::chrono::milliseconds waitReady(bool retry)
+    {
+        bool done = false;
+        bool present = false;
+        ReadyHandler handler = [&](bool p) {
+            done = true;
+            present = p;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        if (retry)
+        {
+            retryWhenReady(cpu0, handler);
+        }
+        else
+        {
+            whenReady(cpu0, handler);
+        }
+        auto& io = dbus::getIOContext();
+        io.restart();
+        while (!done && std::chrono::steady_clock::now() - start < 5s)
+        {
+            io.run_one_for(100ms);
+        }
+        EXPECT_TRUE(done);
+        EXPECT_TRUE(present);
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+    }
+};
+
+TEST_F(PECIReadinessTest, BackoffGrowsUntilConfirmed)
+{
+    // Verify a CPU which answers GetCPUID, but whose consumer keeps failing,
+    // is probed less and less often until the consumer reports success.
+
+    peci_sim::addCPU(cpu0, peci_sim::makeSSTCPU());
+    waitReady(false);
+
+    std::chrono::milliseconds first = waitReady(true);
+    std::chrono::milliseconds second = waitReady(true);
+    EXPECT_GE(first, readinessProbeMin);
+    EXPECT_GE(second, 2 * readinessProbeMin);
+
+    confirmReady(cpu0);
+    std::chrono::milliseconds third = waitReady(true);
+    EXPECT_GE(third, readinessProbeMin);
+    EXPECT_LT(third, 2 * readinessProbeMin);
+}
+
+} // namespace cpu_info::peci
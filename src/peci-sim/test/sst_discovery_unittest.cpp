@@ -0,0 +1,294 @@
+#include "peci_sim.hpp"
+#include "sst_discovery.hpp"
+
+#include <numeric>
+#include <optional>
+#include <stop_token>
+
+#include <gtest/gtest.h>
+
+namespace cpu_info::sst
+{
+
+static constexpr uint8_t cpu0 = MIN_CLIENT_ADDR;
+
+class SSTDiscoveryTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        peci_sim::reset();
+    }
+};
+
+TEST_F(SSTDiscoveryTest, AbsentSocket)
+{
+    // Verify an empty socket is reported absent.
+
+    EXPECT_EQ(discoverCPU(cpu0, std::stop_token()).status,
+              SocketStatus::absent);
+}
+
+TEST_F(SSTDiscoveryTest, DiscoversCurrentLevel)
+{
+    // Verify the current level is discovered with the values reported through
+    // the OS Mailbox, and the other supported levels are left pending.
+
+    peci_sim::addCPU(cpu0, peci_sim::makeSSTCPU());
+
+    SocketDiscovery result = discoverCPU(cpu0, std::stop_token());
+    ASSERT_EQ(result.status, SocketStatus::discovered);
+    EXPECT_EQ(result.cpu.index, 0U);
+    EXPECT_EQ(result.cpu.currentLevel, 0U);
+    EXPECT_FALSE(result.cpu.bfEnabled);
+
+    ASSERT_EQ(result.cpu.levels.size(), 1U);
+    const LevelConfig& base = result.cpu.levels[0];
+    EXPECT_EQ(base.level, 0U);
+    EXPECT_EQ(base.powerLimit, 350U);
+    EXPECT_EQ(base.availableCoreCount, 56U);
+    EXPECT_EQ(base.baseSpeed, 2000U);
+    EXPECT_EQ(base.maxSpeed, 3800U);
+    EXPECT_EQ(base.maxJunctionTemperature, 100U);
+    ASSERT_EQ(base.baseSpeedPrioritySettings.size(), 2U);
+    EXPECT_EQ(std::get<0>(base.baseSpeedPrioritySettings[0]), 2600U);
+    EXPECT_EQ(std::get<1>(base.baseSpeedPrioritySettings[0]).size(), 16U);
+    EXPECT_EQ(std::get<1>(base.baseSpeedPrioritySettings[1]).size(), 40U);
+    ASSERT_EQ(base.turboProfile.size(), 8U);
+    EXPECT_EQ(base.turboProfile[0], TurboEntry(4200, 8));
+
+    EXPECT_EQ(result.cpu.pendingLevels, (std::vector<unsigned int>{3, 4}));
+}
+
+TEST_F(SSTDiscoveryTest, DiscoversPendingLevels)
+{
+    // Verify the levels other than the current one can be read later, one at
+    // a time.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+    cpu.currentLevel = 3;
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    SocketDiscovery result = discoverCPU(cpu0, std::stop_token());
+    ASSERT_EQ(result.status, SocketStatus::discovered);
+    ASSERT_EQ(result.cpu.levels.size(), 1U);
+    EXPECT_EQ(result.cpu.levels[0].level, 3U);
+    EXPECT_EQ(result.cpu.levels[0].availableCoreCount, 48U);
+    ASSERT_EQ(result.cpu.pendingLevels, (std::vector<unsigned int>{0, 4}));
+    ASSERT_TRUE(result.cpu.sst);
+
+    LevelConfig base = discoverLevel(*result.cpu.sst, 0);
+    EXPECT_EQ(base.level, 0U);
+    EXPECT_EQ(base.powerLimit, 350U);
+    EXPECT_EQ(base.availableCoreCount, 56U);
+
+    LevelConfig level4 = discoverLevel(*result.cpu.sst, 4);
+    EXPECT_EQ(level4.level, 4U);
+    EXPECT_EQ(level4.powerLimit, 270U);
+    EXPECT_TRUE(level4.baseSpeedPrioritySettings.empty());
+
+    // The package-scope TRL cores and core count MSRs are read once for all
+    // levels, since the pending ones are read with the instance from
+    // discovery.
+    EXPECT_EQ(peci_sim::transactions(cpu0)["RdIAMSR"], 2U);
+}
+
+TEST_F(SSTDiscoveryTest, WideCoreMasks)
+{
+    // Verify core masks are read for as many words as the CPU has cores, so
+    // that cores beyond the first 64 are listed.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+    cpu.coreMaskWords = 3;
+    cpu.msrs[0x35] = (96 << 16) | 192;
+    std::vector<unsigned int> cores(96);
+    std::iota(cores.begin(), cores.end(), 0U);
+    cpu.levels[0].cores = cores;
+    cpu.levels[0].bfHighPriorityCores = {3, 70, 95};
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    SocketDiscovery result = discoverCPU(cpu0, std::stop_token());
+    ASSERT_EQ(result.status, SocketStatus::discovered);
+    const LevelConfig& base = result.cpu.levels[0];
+    EXPECT_EQ(base.availableCoreCount, 96U);
+    ASSERT_EQ(base.baseSpeedPrioritySettings.size(), 2U);
+    EXPECT_EQ(std::get<1>(base.baseSpeedPrioritySettings[0]),
+              (std::vector<uint32_t>{3, 70, 95}));
+    EXPECT_EQ(std::get<1>(base.baseSpeedPrioritySettings[1]).size(), 93U);
+}
+
+TEST_F(SSTDiscoveryTest, CoreMaskStopsAtCoreCount)
+{
+    // Verify no core mask words past the CPU's core count are read, since
+    // pcode may wrap the word index around rather than reject it.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+    cpu.coreMaskIndexWraps = true;
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    SocketDiscovery result = discoverCPU(cpu0, std::stop_token());
+    ASSERT_EQ(result.status, SocketStatus::discovered);
+    const LevelConfig& base = result.cpu.levels[0];
+    EXPECT_EQ(base.availableCoreCount, 56U);
+    ASSERT_EQ(base.baseSpeedPrioritySettings.size(), 2U);
+    EXPECT_EQ(std::get<1>(base.baseSpeedPrioritySettings[0]).size(), 16U);
+}
+
+TEST_F(SSTDiscoveryTest, AppliesBfAndTfTogether)
+{
+    // Verify SST-BF and SST-TF can be enabled in the same apply, along with a
+    // level change.
+
+    peci_sim::addCPU(cpu0, peci_sim::makeSSTCPU());
+
+    ControlChange change;
+    applyConfig(cpu0, sapphireRapids, 3, true, true, change);
+    EXPECT_TRUE(change.modified);
+    EXPECT_EQ(change.previous.level, 0U);
+    EXPECT_FALSE(change.previous.bfEnabled);
+    EXPECT_FALSE(change.previous.tfEnabled);
+    peci_sim::withCPU(cpu0, [](peci_sim::SimCPU& cpu) {
+        EXPECT_EQ(cpu.currentLevel, 3U);
+        EXPECT_TRUE(cpu.bfEnabled);
+        EXPECT_TRUE(cpu.tfEnabled);
+    });
+}
+
+TEST_F(SSTDiscoveryTest, ApplyLockedConfig)
+{
+    // Verify a level change is refused when the BIOS locked the SST-PP
+    // config, and the CPU is left as it was.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+    cpu.ppLocked = true;
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    ControlChange change;
+    EXPECT_THROW(applyConfig(cpu0, sapphireRapids, 3, std::nullopt,
+                             std::nullopt, change),
+                 PECIError);
+    EXPECT_FALSE(change.modified);
+    peci_sim::withCPU(cpu0, [](peci_sim::SimCPU& cpu) {
+        EXPECT_EQ(cpu.currentLevel, 0U);
+    });
+}
+
+TEST_F(SSTDiscoveryTest, ApplyKeepsOtherFeature)
+{
+    // Verify applying only SST-TF leaves SST-BF as it was.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+    cpu.bfEnabled = true;
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    ControlChange change;
+    applyConfig(cpu0, sapphireRapids, 0, std::nullopt, true, change);
+    peci_sim::withCPU(cpu0, [](peci_sim::SimCPU& cpu) {
+        EXPECT_TRUE(cpu.bfEnabled);
+        EXPECT_TRUE(cpu.tfEnabled);
+    });
+}
+
+TEST_F(SSTDiscoveryTest, RestoresBfAndTf)
+{
+    // Verify restoring after an apply brings back the level and both the
+    // SST-BF and SST-TF state.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+    cpu.bfEnabled = true;
+    cpu.tfEnabled = true;
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    ControlChange change;
+    applyConfig(cpu0, sapphireRapids, 4, false, false, change);
+    peci_sim::withCPU(cpu0, [](peci_sim::SimCPU& cpu) {
+        EXPECT_EQ(cpu.currentLevel, 4U);
+        EXPECT_FALSE(cpu.bfEnabled);
+        EXPECT_FALSE(cpu.tfEnabled);
+    });
+
+    restoreConfig(cpu0, sapphireRapids, change.previous);
+    peci_sim::withCPU(cpu0, [](peci_sim::SimCPU& cpu) {
+        EXPECT_EQ(cpu.currentLevel, 0U);
+        EXPECT_TRUE(cpu.bfEnabled);
+        EXPECT_TRUE(cpu.tfEnabled);
+    });
+}
+
+TEST_F(SSTDiscoveryTest, SlowMailbox)
+{
+    // Verify discovery waits for RUN_BUSY to clear.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+    cpu.mailboxBusyTime = std::chrono::microseconds(500);
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    EXPECT_EQ(discoverCPU(cpu0, std::stop_token()).status,
+              SocketStatus::discovered);
+}
+
+TEST_F(SSTDiscoveryTest, WakesSleepingCPU)
+{
+    // Verify a CPU in a deep package C-state is woken with Wake-On-PECI.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+    cpu.asleep = true;
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    EXPECT_EQ(discoverCPU(cpu0, std::stop_token()).status,
+              SocketStatus::discovered);
+    peci_sim::withCPU(cpu0, [](peci_sim::SimCPU& cpu) {
+        EXPECT_TRUE(cpu.wakeOnPECI);
+    });
+}
+
+TEST_F(SSTDiscoveryTest, DontWakeSleepingCPU)
+{
+    // Verify reads which may not wake the CPU fail with a PECISleepingError
+    // while it is in a deep package C-state, so they can be told apart from
+    // real failures.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+    cpu.asleep = true;
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    std::unique_ptr<SSTInterface> sst =
+        getInstance(cpu0, sapphireRapids, dontWake);
+    ASSERT_TRUE(sst);
+    EXPECT_THROW(sst->currentLevel(), PECISleepingError);
+    peci_sim::withCPU(cpu0, [](peci_sim::SimCPU& cpu) {
+        EXPECT_FALSE(cpu.wakeOnPECI);
+    });
+}
+
+TEST_F(SSTDiscoveryTest, GetCPUIDTimeout)
+{
+    // Verify a CPU whose PCS services aren't ready yet raises a PECIError, so
+    // discovery is retried.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+    cpu.faultHook = [](const std::string& command) {
+        return command == "GetCPUID" ? peci_sim::Fault::timeout
+                                     : peci_sim::Fault::none;
+    };
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    EXPECT_THROW(discoverCPU(cpu0, std::stop_token()), PECIError);
+}
+
+TEST_F(SSTDiscoveryTest, MailboxFailure)
+{
+    // Verify a failing mailbox access raises a PECIError.
+
+    peci_sim::SimCPU cpu = peci_sim::makeSSTCPU();
+    cpu.faultHook = [](const std::string& command) {
+        return command == "RdEndPointConfigPciLocal"
+                   ? peci_sim::Fault::driverError
+                   : peci_sim::Fault::none;
+    };
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    EXPECT_THROW(discoverCPU(cpu0, std::stop_token()), PECIError);
+}
+
+} // namespace cpu_info::sst
@@ -0,0 +1,114 @@
+#include "peci_sim.hpp"
+#include "sst_discovery.hpp"
+
+#include <algorithm>
+#include <stop_token>
+
+#include <gtest/gtest.h>
+
+namespace cpu_info::sst
+{
+
+static constexpr uint8_t cpu0 = MIN_CLIENT_ADDR;
+
+class SSTTPMITest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        peci_sim::reset();
+    }
+};
+
+TEST_F(SSTTPMITest, DiscoversAllLevels)
+{
+    // Verify every level of a Granite Rapids CPU is discovered through TPMI,
+    // with the cores of both power domains. Discovery reads the current level,
+    // and the others are read afterwards.
+
+    peci_sim::addCPU(cpu0, peci_sim::makeTPMICPU());
+
+    SocketDiscovery result = discoverCPU(cpu0, std::stop_token());
+    ASSERT_EQ(result.status, SocketStatus::discovered);
+    EXPECT_EQ(result.cpu.model, graniteRapids);
+    EXPECT_EQ(result.cpu.currentLevel, 0U);
+    EXPECT_FALSE(result.cpu.bfEnabled);
+
+    ASSERT_EQ(result.cpu.levels.size(), 1U);
+    const LevelConfig& base = result.cpu.levels[0];
+    EXPECT_EQ(base.level, 0U);
+    EXPECT_EQ(base.powerLimit, 350U);
+    EXPECT_EQ(base.availableCoreCount, 120U);
+    EXPECT_EQ(base.baseSpeed, 2000U);
+    EXPECT_EQ(base.maxSpeed, 3800U);
+    EXPECT_EQ(base.maxJunctionTemperature, 100U);
+    ASSERT_EQ(base.baseSpeedPrioritySettings.size(), 2U);
+    EXPECT_EQ(std::get<0>(base.baseSpeedPrioritySettings[0]), 2600U);
+    EXPECT_EQ(std::get<0>(base.baseSpeedPrioritySettings[1]), 1800U);
+    const std::vector<uint32_t>& highPriority =
+        std::get<1>(base.baseSpeedPrioritySettings[0]);
+    ASSERT_EQ(highPriority.size(), 16U);
+    EXPECT_EQ(highPriority[7], 7U);
+    EXPECT_EQ(highPriority[8], 64U);
+    EXPECT_EQ(std::get<1>(base.baseSpeedPrioritySettings[1]).size(), 104U);
+    ASSERT_EQ(base.turboProfile.size(), 8U);
+    EXPECT_EQ(base.turboProfile[0], TurboEntry(4200, 8));
+
+    ASSERT_EQ(result.cpu.pendingLevels, (std::vector<unsigned int>{3, 4}));
+    ASSERT_TRUE(result.cpu.sst);
+    LevelConfig level3 = discoverLevel(*result.cpu.sst, 3);
+    EXPECT_EQ(level3.level, 3U);
+    EXPECT_EQ(level3.availableCoreCount, 96U);
+    LevelConfig level4 = discoverLevel(*result.cpu.sst, 4);
+    EXPECT_EQ(level4.level, 4U);
+    EXPECT_TRUE(level4.baseSpeedPrioritySettings.empty());
+}
+
+TEST_F(SSTTPMITest, ReadsEachRegisterOnce)
+{
+    // Verify discovery only uses TPMI MMIO reads, and reads every register
+    // block of the current level once.
+
+    peci_sim::addCPU(cpu0, peci_sim::makeTPMICPU());
+
+    ASSERT_EQ(discoverCPU(cpu0, std::stop_token()).status,
+              SocketStatus::discovered);
+
+    std::map<std::string, uint64_t> transactions =
+        peci_sim::transactions(cpu0);
+    EXPECT_EQ(transactions.count("RdEndPointConfigPciLocal"), 0U);
+    EXPECT_EQ(transactions.count("WrEndPointPCIConfigLocal"), 0U);
+
+    // 2 PFS entries, then for each of the 2 power domains: the SST header,
+    // 5 SST-PP registers, and the 12 PP info and 2 BF info registers of the
+    // current level.
+    EXPECT_EQ(transactions["RdEndPointConfigMmio"], 2U + 2 * (1 + 5 + 12 + 2));
+}
+
+TEST_F(SSTTPMITest, NotReadyWithoutSSTInstances)
+{
+    // Verify a CPU whose BIOS hasn't set up the SST instances yet is retried.
+
+    peci_sim::SimCPU cpu = peci_sim::makeTPMICPU();
+    cpu.powerDomains = 0;
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    EXPECT_EQ(discoverCPU(cpu0, std::stop_token()).status,
+              SocketStatus::notReady);
+}
+
+TEST_F(SSTTPMITest, MmioFailure)
+{
+    // Verify a failing MMIO read raises a PECIError.
+
+    peci_sim::SimCPU cpu = peci_sim::makeTPMICPU();
+    cpu.faultHook = [](const std::string& command) {
+        return command == "RdEndPointConfigMmio" ? peci_sim::Fault::driverError
+                                                 : peci_sim::Fault::none;
+    };
+    peci_sim::addCPU(cpu0, std::move(cpu));
+
+    EXPECT_THROW(discoverCPU(cpu0, std::stop_token()), PECIError);
+}
+
+} // namespace cpu_info::sst
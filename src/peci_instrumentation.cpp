@@ -0,0 +1,338 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "peci_instrumentation.hpp"
+
+#include "cpuinfo.hpp"
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace cpu_info
+{
+namespace peci
+{
+
+static constexpr const char* metricsInterface =
+    "xyz.openbmc_project.CPUInfo.PECIMetrics";
+
+enum class Command
+{
+    getCPUID,
+    rdPkgConfig,
+    wrPkgConfig,
+    rdIAMSR,
+    rdEndPointConfigPciLocal,
+    wrEndPointPCIConfigLocal,
+    rdEndPointConfigMmio,
+    count
+};
+
+static constexpr std::array<const char*, static_cast<size_t>(Command::count)>
+    commandNames = {
+        "GetCPUID",
+        "RdPkgConfig",
+        "WrPkgConfig",
+        "RdIAMSR",
+        "RdEndPointConfigPciLocal",
+        "WrEndPointPCIConfigLocal",
+        "RdEndPointConfigMmio",
+};
+
+/**
+ * Upper bounds of the latency histogram buckets, in microseconds. The last
+ * bucket counts everything slower than the last bound.
+ */
+static constexpr std::array<uint64_t, 10> latencyBounds = {
+    50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000};
+
+using Counter = std::atomic<uint64_t>;
+
+struct CommandCounters
+{
+    Counter calls;
+    /** Calls which returned a driver status other than success. */
+    Counter failures;
+    std::array<Counter, latencyBounds.size() + 1> latency;
+    std::array<Counter, 256> completionCodes;
+};
+
+struct MailboxCounters
+{
+    Counter commands;
+    Counter polls;
+    Counter maxPolls;
+    Counter totalMicroseconds;
+    Counter maxMicroseconds;
+};
+
+static std::array<CommandCounters, static_cast<size_t>(Command::count)>
+    commandCounters;
+static std::array<MailboxCounters, 256> mailboxCounters;
+static Counter wakeOnPECISet;
+static Counter wakeOnPECICleared;
+
+static constexpr std::array<const char*, static_cast<size_t>(Retry::count)>
+    retryNames = {
+        "ReadinessProbe",
+        "RetryWhenReady",
+        "MailboxBusy",
+        "WakeOnPECI",
+};
+static std::array<Counter, static_cast<size_t>(Retry::count)> retryCounters;
+
+static void increment(Counter& counter, uint64_t value = 1)
+{
+    counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+static uint64_t load(const Counter& counter)
+{
+    return counter.load(std::memory_order_relaxed);
+}
+
+static void updateMax(Counter& counter, uint64_t value)
+{
+    uint64_t current = load(counter);
+    while (current < value &&
+           !counter.compare_exchange_weak(current, value,
+                                          std::memory_order_relaxed))
+    {}
+}
+
+template <typename Fn>
+static EPECIStatus instrument(Command command, uint8_t* cc, Fn&& fn)
+{
+    // Not every failure path in libpeci fills in the completion code.
+    *cc = 0;
+    auto start = std::chrono::steady_clock::now();
+    EPECIStatus status = fn();
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+
+    CommandCounters& counters = commandCounters[static_cast<size_t>(command)];
+    increment(counters.calls);
+    if (status != PECI_CC_SUCCESS)
+    {
+        increment(counters.failures);
+    }
+    increment(counters.completionCodes[*cc]);
+
+    size_t bucket = 0;
+    while (bucket < latencyBounds.size() && elapsed > latencyBounds[bucket])
+    {
+        bucket++;
+    }
+    increment(counters.latency[bucket]);
+    return status;
+}
+
+EPECIStatus getCPUID(uint8_t target, CPUModel* cpuModel, uint8_t* stepping,
+                     uint8_t* cc)
+{
+    return instrument(Command::getCPUID, cc, [&]() {
+        return peci_GetCPUID(target, cpuModel, stepping, cc);
+    });
+}
+
+EPECIStatus rdPkgConfig(uint8_t target, uint8_t index, uint16_t param,
+                        uint8_t readLen, uint8_t* data, uint8_t* cc)
+{
+    return instrument(Command::rdPkgConfig, cc, [&]() {
+        return peci_RdPkgConfig(target, index, param, readLen, data, cc);
+    });
+}
+
+EPECIStatus wrPkgConfig(uint8_t target, uint8_t index, uint16_t param,
+                        uint32_t value, uint8_t writeLen, uint8_t* cc)
+{
+    return instrument(Command::wrPkgConfig, cc, [&]() {
+        return peci_WrPkgConfig(target, index, param, value, writeLen, cc);
+    });
+}
+
+EPECIStatus rdIAMSR(uint8_t target, uint8_t threadID, uint16_t msrAddress,
+                    uint64_t* value, uint8_t* cc)
+{
+    return instrument(Command::rdIAMSR, cc, [&]() {
+        return peci_RdIAMSR(target, threadID, msrAddress, value, cc);
+    });
+}
+
+EPECIStatus rdEndPointConfigPciLocal(uint8_t target, uint8_t seg, uint8_t bus,
+                                     uint8_t device, uint8_t fcn, uint16_t reg,
+                                     uint8_t readLen, uint8_t* data,
+                                     uint8_t* cc)
+{
+    return instrument(Command::rdEndPointConfigPciLocal, cc, [&]() {
+        return peci_RdEndPointConfigPciLocal(target, seg, bus, device, fcn, reg,
+                                             readLen, data, cc);
+    });
+}
+
+EPECIStatus wrEndPointPCIConfigLocal(uint8_t target, uint8_t seg, uint8_t bus,
+                                     uint8_t device, uint8_t fcn, uint16_t reg,
+                                     uint8_t dataLen, uint32_t value,
+                                     uint8_t* cc)
+{
+    return instrument(Command::wrEndPointPCIConfigLocal, cc, [&]() {
+        return peci_WrEndPointPCIConfigLocal(target, seg, bus, device, fcn, reg,
+                                             dataLen, value, cc);
+    });
+}
+
+EPECIStatus rdEndPointConfigMmio(uint8_t target, uint8_t seg, uint8_t bus,
+                                 uint8_t device, uint8_t fcn, uint8_t bar,
+                                 uint8_t addrType, uint64_t offset,
+                                 uint8_t readLen, uint8_t* data, uint8_t* cc)
+{
+    return instrument(Command::rdEndPointConfigMmio, cc, [&]() {
+        return peci_RdEndPointConfigMmio(target, seg, bus, device, fcn, bar,
+                                         addrType, offset, readLen, data, cc);
+    });
+}
+
+void recordWakeOnPECI(bool enable)
+{
+    increment(enable ? wakeOnPECISet : wakeOnPECICleared);
+}
+
+void recordMailboxCommand(uint8_t subCommand, unsigned int polls,
+                          std::chrono::microseconds duration)
+{
+    MailboxCounters& counters = mailboxCounters[subCommand];
+    increment(counters.commands);
+    increment(counters.polls, polls);
+    updateMax(counters.maxPolls, polls);
+    increment(counters.totalMicroseconds, duration.count());
+    updateMax(counters.maxMicroseconds, duration.count());
+}
+
+void recordRetry(Retry retry)
+{
+    increment(retryCounters[static_cast<size_t>(retry)]);
+}
+
+// (calls, failures, latency histogram)
+using CommandMetrics =
+    std::map<std::string,
+             std::tuple<uint64_t, uint64_t, std::vector<uint64_t>>>;
+using CompletionCodeMetrics =
+    std::map<std::string, std::map<uint8_t, uint64_t>>;
+// (commands, polls, max polls, total microseconds, max microseconds)
+using MailboxMetrics =
+    std::map<uint8_t, std::tuple<uint64_t, uint64_t, uint64_t, uint64_t,
+                                 uint64_t>>;
+
+static CommandMetrics commandMetrics()
+{
+    CommandMetrics metrics;
+    for (size_t i = 0; i < commandCounters.size(); i++)
+    {
+        const CommandCounters& counters = commandCounters[i];
+        std::vector<uint64_t> histogram;
+        for (const Counter& bucket : counters.latency)
+        {
+            histogram.push_back(load(bucket));
+        }
+        metrics[commandNames[i]] = {load(counters.calls),
+                                    load(counters.failures),
+                                    std::move(histogram)};
+    }
+    return metrics;
+}
+
+static CompletionCodeMetrics completionCodeMetrics()
+{
+    CompletionCodeMetrics metrics;
+    for (size_t i = 0; i < commandCounters.size(); i++)
+    {
+        std::map<uint8_t, uint64_t>& codes = metrics[commandNames[i]];
+        const auto& counters = commandCounters[i].completionCodes;
+        for (size_t cc = 0; cc < counters.size(); cc++)
+        {
+            if (uint64_t count = load(counters[cc]))
+            {
+                codes[static_cast<uint8_t>(cc)] = count;
+            }
+        }
+    }
+    return metrics;
+}
+
+static std::map<std::string, uint64_t> retryMetrics()
+{
+    std::map<std::string, uint64_t> metrics;
+    for (size_t i = 0; i < retryCounters.size(); i++)
+    {
+        metrics[retryNames[i]] = load(retryCounters[i]);
+    }
+    return metrics;
+}
+
+static MailboxMetrics mailboxMetrics()
+{
+    MailboxMetrics metrics;
+    for (size_t sub = 0; sub < mailboxCounters.size(); sub++)
+    {
+        const MailboxCounters& counters = mailboxCounters[sub];
+        if (uint64_t commands = load(counters.commands))
+        {
+            metrics[static_cast<uint8_t>(sub)] = {
+                commands, load(counters.polls), load(counters.maxPolls),
+                load(counters.totalMicroseconds),
+                load(counters.maxMicroseconds)};
+        }
+    }
+    return metrics;
+}
+
+void initMetrics(sdbusplus::asio::object_server& objServer)
+{
+    static std::shared_ptr<sdbusplus::asio::dbus_interface> iface =
+        objServer.add_interface(cpuInfoPath, metricsInterface);
+
+    iface->register_property(
+        "LatencyBucketsUs",
+        std::vector<uint64_t>(latencyBounds.begin(), latencyBounds.end()));
+    iface->register_property_r(
+        "Commands", CommandMetrics(), sdbusplus::vtable::property_::none,
+        [](const auto&) { return commandMetrics(); });
+    iface->register_property_r(
+        "CompletionCodes", CompletionCodeMetrics(),
+        sdbusplus::vtable::property_::none,
+        [](const auto&) { return completionCodeMetrics(); });
+    iface->register_property_r(
+        "MailboxCommands", MailboxMetrics(), sdbusplus::vtable::property_::none,
+        [](const auto&) { return mailboxMetrics(); });
+    iface->register_property_r(
+        "Retries", std::map<std::string, uint64_t>(),
+        sdbusplus::vtable::property_::none,
+        [](const auto&) { return retryMetrics(); });
+    iface->register_property_r("WakeOnPECISet", uint64_t(0),
+                               sdbusplus::vtable::property_::none,
+                               [](const auto&) { return load(wakeOnPECISet); });
+    iface->register_property_r(
+        "WakeOnPECICleared", uint64_t(0), sdbusplus::vtable::property_::none,
+        [](const auto&) { return load(wakeOnPECICleared); });
+    iface->initialize();
+}
+
+} // namespace peci
+} // namespace cpu_info
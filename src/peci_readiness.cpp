@@ -0,0 +1,223 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "peci_readiness.hpp"
+
+#include "cpuinfo_utils.hpp"
+#include "peci_instrumentation.hpp"
+#include "peci_worker.hpp"
+
+#include <peci.h>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+namespace cpu_info
+{
+namespace peci
+{
+
+static constexpr size_t maxCPUs = MAX_CLIENT_ADDR - MIN_CLIENT_ADDR + 1;
+
+enum class Readiness
+{
+    unknown,
+    ready,
+    absent
+};
+
+/** Readiness of one CPU. Only accessed from the io_context. */
+struct CPUReadiness
+{
+    Readiness state = Readiness::unknown;
+    /** Set while a probe is queued or running on the PECI worker. */
+    bool probing = false;
+    /** Handlers waiting for the CPU to respond. */
+    std::vector<ReadyHandler> waiters;
+    /** Delay before the next delayed probe. */
+    std::chrono::milliseconds backoff = readinessProbeMin;
+    /** Set while a delayed probe is scheduled. */
+    std::optional<boost::asio::steady_timer> timer;
+    /**
+     * Incremented whenever the host powers off, so that a probe started
+     * before that can tell its result is stale.
+     */
+    uint64_t generation = 0;
+};
+
+static CPUReadiness& readiness(uint8_t address)
+{
+    static std::array<CPUReadiness, maxCPUs> cpus;
+    return cpus.at(address - MIN_CLIENT_ADDR);
+}
+
+static void setReady(uint8_t address, bool present)
+{
+    CPUReadiness& cpu = readiness(address);
+    cpu.state = present ? Readiness::ready : Readiness::absent;
+
+    // Handlers may queue themselves again, so take them out first.
+    std::vector<ReadyHandler> waiters = std::move(cpu.waiters);
+    cpu.waiters.clear();
+    for (ReadyHandler& handler : waiters)
+    {
+        handler(present);
+    }
+}
+
+static void scheduleProbe(uint8_t address);
+
+static void probe(uint8_t address)
+{
+    CPUReadiness& cpu = readiness(address);
+    cpu.timer.reset();
+    if (hostState == HostState::off)
+    {
+        // Probed again once the host powers on.
+        return;
+    }
+
+    cpu.probing = true;
+    getWorker().post(
+        [address]() {
+            CPUModel model{};
+            uint8_t stepping = 0;
+            uint8_t cc = 0;
+            return getCPUID(address, &model, &stepping, &cc);
+        },
+        [address, generation = cpu.generation](std::exception_ptr err,
+                                               EPECIStatus status) {
+            CPUReadiness& cpu = readiness(address);
+            if (generation != cpu.generation)
+            {
+                return;
+            }
+            cpu.probing = false;
+            if (err || (status != PECI_CC_SUCCESS &&
+                        status != PECI_CC_CPU_NOT_PRESENT))
+            {
+                recordRetry(Retry::readinessProbe);
+                scheduleProbe(address);
+                return;
+            }
+            DEBUG_PRINT << "CPU " << address - MIN_CLIENT_ADDR
+                        << (status == PECI_CC_SUCCESS ? " ready\n"
+                                                      : " not present\n");
+            setReady(address, status == PECI_CC_SUCCESS);
+        });
+}
+
+/**
+ * Probe the CPU after the current backoff, and double the backoff for the
+ * next time.
+ */
+static void scheduleProbe(uint8_t address)
+{
+    CPUReadiness& cpu = readiness(address);
+    if (cpu.probing || cpu.timer)
+    {
+        return;
+    }
+
+    cpu.timer.emplace(dbus::getIOContext(), cpu.backoff);
+    cpu.timer->async_wait([address](boost::system::error_code ec) {
+        if (ec)
+        {
+            return;
+        }
+        probe(address);
+    });
+    cpu.backoff = std::min(cpu.backoff * 2, readinessProbeMax);
+}
+
+void whenReady(uint8_t address, ReadyHandler handler)
+{
+    CPUReadiness& cpu = readiness(address);
+    if (cpu.state != Readiness::unknown)
+    {
+        boost::asio::post(dbus::getIOContext(),
+                          [handler = std::move(handler),
+                           present = cpu.state == Readiness::ready]() {
+                              handler(present);
+                          });
+        return;
+    }
+
+    cpu.waiters.push_back(std::move(handler));
+    if (!cpu.probing && !cpu.timer)
+    {
+        probe(address);
+    }
+}
+
+void retryWhenReady(uint8_t address, ReadyHandler handler)
+{
+    recordRetry(Retry::retryWhenReady);
+    CPUReadiness& cpu = readiness(address);
+    cpu.state = Readiness::unknown;
+    cpu.waiters.push_back(std::move(handler));
+    scheduleProbe(address);
+}
+
+void confirmReady(uint8_t address)
+{
+    readiness(address).backoff = readinessProbeMin;
+}
+
+static void hostStateHandler(HostState prevState, HostState newState)
+{
+    for (uint8_t address = MIN_CLIENT_ADDR; address <= MAX_CLIENT_ADDR;
+         address++)
+    {
+        CPUReadiness& cpu = readiness(address);
+        if (newState == HostState::off)
+        {
+            // The CPUs may be swapped while the host is off, and the work of
+            // any waiters is cancelled anyway.
+            cpu.generation++;
+            cpu.state = Readiness::unknown;
+            cpu.probing = false;
+            cpu.waiters.clear();
+            cpu.timer.reset();
+            cpu.backoff = readinessProbeMin;
+            continue;
+        }
+
+        if (prevState == HostState::off || newState == HostState::postComplete)
+        {
+            // Anything which failed during POST likely works now, so probe
+            // right away instead of waiting out the backoff.
+            cpu.backoff = readinessProbeMin;
+            if (cpu.state == Readiness::unknown && !cpu.waiters.empty() &&
+                !cpu.probing)
+            {
+                probe(address);
+            }
+        }
+    }
+}
+
+void initReadiness()
+{
+    addHostStateCallback(hostStateHandler);
+}
+
+} // namespace peci
+} // namespace cpu_info
@@ -0,0 +1,93 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "peci_worker.hpp"
+
+#include "cpuinfo_utils.hpp"
+
+namespace cpu_info
+{
+namespace peci
+{
+
+Worker::Worker(boost::asio::io_context& ioc, unsigned int threadCount) :
+    ioc(ioc)
+{
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        threads.emplace_back([this] { run(); });
+    }
+}
+
+Worker::~Worker()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+        stopSource.request_stop();
+    }
+    cv.notify_all();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void Worker::cancelAll()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopSource.request_stop();
+        stopSource = std::stop_source();
+    }
+    // Wake the workers so they drain the cancelled requests right away.
+    cv.notify_all();
+}
+
+void Worker::enqueue(Job job)
+{
+    {
+        std::lock_guard lock(mutex);
+        queue.push_back({std::move(job), stopSource.get_token()});
+    }
+    cv.notify_one();
+}
+
+void Worker::run()
+{
+    while (true)
+    {
+        QueuedJob next;
+        {
+            std::unique_lock lock(mutex);
+            cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+            next = std::move(queue.front());
+            queue.pop_front();
+        }
+        next.job(std::move(next.stop));
+    }
+}
+
+Worker& getWorker()
+{
+    static Worker worker(dbus::getIOContext(), workerThreads);
+    return worker;
+}
+
+} // namespace peci
+} // namespace cpu_info
@@ -0,0 +1,273 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pirom.hpp"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <boost/container/flat_map.hpp>
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <mutex>
+#include <random>
+
+extern "C"
+{
+#include <i2c/smbus.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+}
+
+namespace cpu_info
+{
+
+/**
+ * An open I2C adapter, along with the functionality it reported. These are
+ * kept open so that PIROM retries don't have to re-open and re-query the
+ * adapter every time, until a transfer finds the adapter gone.
+ */
+struct I2cAdapter
+{
+    int fd;
+    unsigned long funcs;
+};
+
+// cpuinfoapp reads PIROMs on several buses from a thread pool.
+static std::mutex adaptersMutex;
+static boost::container::flat_map<uint8_t, I2cAdapter> adapters;
+
+static std::optional<I2cAdapter> getI2cAdapter(uint8_t bus)
+{
+    std::lock_guard lock(adaptersMutex);
+
+    auto it = adapters.find(bus);
+    if (it != adapters.end())
+    {
+        return it->second;
+    }
+
+    std::string devPath = "/dev/i2c-" + std::to_string(bus);
+    int fd = ::open(devPath.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Error in open!",
+            phosphor::logging::entry("PATH=%s", devPath.c_str()));
+        return std::nullopt;
+    }
+
+    unsigned long funcs = 0;
+    if (::ioctl(fd, I2C_FUNCS, &funcs) < 0)
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Error in I2C_FUNCS!",
+            phosphor::logging::entry("PATH=%s", devPath.c_str()));
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    return adapters.emplace(bus, I2cAdapter{fd, funcs}).first->second;
+}
+
+/**
+ * Close a cached adapter if a transfer failed because the adapter went away,
+ * e.g. when its driver was unbound, so that the next read re-opens it.
+ * Reads of one bus are serialized by the callers, so no other transfer is
+ * using the fd.
+ *
+ * @param[in]   bus     I2C bus number.
+ * @param[in]   adapter Adapter the transfer failed on.
+ * @param[in]   error   errno of the failed transfer.
+ */
+static void dropI2cAdapterIfGone(uint8_t bus, const I2cAdapter& adapter,
+                                 int error)
+{
+    if (error != ENODEV && error != EBADF)
+    {
+        return;
+    }
+
+    std::lock_guard lock(adaptersMutex);
+    auto it = adapters.find(bus);
+    if (it != adapters.end() && it->second.fd == adapter.fd)
+    {
+        ::close(it->second.fd);
+        adapters.erase(it);
+    }
+}
+
+std::optional<std::vector<uint8_t>>
+    readPiromBlock(uint8_t bus, uint8_t slaveAddr, uint8_t regAddr,
+                   size_t count)
+{
+    std::optional<I2cAdapter> adapter = getI2cAdapter(bus);
+    if (!adapter)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> data(count);
+
+    if (adapter->funcs & I2C_FUNC_I2C)
+    {
+        std::array<i2c_msg, 2> msgs{};
+        msgs[0].addr = slaveAddr;
+        msgs[0].flags = 0;
+        msgs[0].len = sizeof(regAddr);
+        msgs[0].buf = &regAddr;
+        msgs[1].addr = slaveAddr;
+        msgs[1].flags = I2C_M_RD;
+        msgs[1].len = static_cast<uint16_t>(count);
+        msgs[1].buf = data.data();
+
+        i2c_rdwr_ioctl_data xfer{};
+        xfer.msgs = msgs.data();
+        xfer.nmsgs = msgs.size();
+
+        if (::ioctl(adapter->fd, I2C_RDWR, &xfer) < 0)
+        {
+            dropI2cAdapterIfGone(bus, *adapter, errno);
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "Error in I2C_RDWR!",
+                phosphor::logging::entry("BUS=%d", bus),
+                phosphor::logging::entry("SLAVEADDR=0x%x", slaveAddr));
+            return std::nullopt;
+        }
+        return data;
+    }
+
+    if (!(adapter->funcs &
+          (I2C_FUNC_SMBUS_READ_I2C_BLOCK | I2C_FUNC_SMBUS_READ_BYTE_DATA)))
+    {
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "i2c bus does not support read!",
+            phosphor::logging::entry("BUS=%d", bus),
+            phosphor::logging::entry("SLAVEADDR=0x%x", slaveAddr));
+        return std::nullopt;
+    }
+
+    if (::ioctl(adapter->fd, I2C_SLAVE_FORCE, slaveAddr) < 0)
+    {
+        dropI2cAdapterIfGone(bus, *adapter, errno);
+        phosphor::logging::log<phosphor::logging::level::ERR>(
+            "Error in I2C_SLAVE_FORCE!",
+            phosphor::logging::entry("BUS=%d", bus),
+            phosphor::logging::entry("SLAVEADDR=0x%x", slaveAddr));
+        return std::nullopt;
+    }
+
+    if (adapter->funcs & I2C_FUNC_SMBUS_READ_I2C_BLOCK)
+    {
+        // SMBus limits each block to I2C_SMBUS_BLOCK_MAX bytes.
+        for (size_t offset = 0; offset < count; offset += I2C_SMBUS_BLOCK_MAX)
+        {
+            size_t chunk = std::min<size_t>(count - offset,
+                                            I2C_SMBUS_BLOCK_MAX);
+            int ret = ::i2c_smbus_read_i2c_block_data(
+                adapter->fd, static_cast<uint8_t>(regAddr + offset),
+                static_cast<uint8_t>(chunk), data.data() + offset);
+            if (ret != static_cast<int>(chunk))
+            {
+                if (ret < 0)
+                {
+                    dropI2cAdapterIfGone(bus, *adapter, -ret);
+                }
+                phosphor::logging::log<phosphor::logging::level::ERR>(
+                    "Error in i2c block read!",
+                    phosphor::logging::entry("BUS=%d", bus),
+                    phosphor::logging::entry("SLAVEADDR=0x%x", slaveAddr));
+                return std::nullopt;
+            }
+        }
+        return data;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        int value = ::i2c_smbus_read_byte_data(adapter->fd, regAddr + i);
+        if (value < 0)
+        {
+            dropI2cAdapterIfGone(bus, *adapter, -value);
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "Error in i2c read!",
+                phosphor::logging::entry("BUS=%d", bus),
+                phosphor::logging::entry("SLAVEADDR=0x%x", slaveAddr));
+            return std::nullopt;
+        }
+        data[i] = static_cast<uint8_t>(value);
+    }
+    return data;
+}
+
+std::optional<PiromInfo> readPirom(uint8_t bus, uint8_t slaveAddr)
+{
+    std::optional<std::vector<uint8_t>> field =
+        readPiromBlock(bus, slaveAddr, sspecRegAddr, sspecSize);
+    if (!field)
+    {
+        return std::nullopt;
+    }
+
+    PiromInfo info{};
+    info.sSpec.reserve(sspecSize);
+
+    for (size_t i = 0; i < field->size(); i++)
+    {
+        uint8_t value = (*field)[i];
+        if (!std::isprint(value))
+        {
+            phosphor::logging::log<phosphor::logging::level::ERR>(
+                "Non printable value in sspec, ignored.");
+            continue;
+        }
+        // sspec always starts with S,
+        // if not assume it is QDF string which starts at offset 2
+        if (i == 0 && value != 'S')
+        {
+            i = 1;
+            continue;
+        }
+        info.sSpec.push_back(static_cast<char>(value));
+    }
+
+    if (info.sSpec.size() < 4)
+    {
+        return std::nullopt;
+    }
+    return info;
+}
+
+std::chrono::milliseconds sspecRetryDelay(unsigned int failedReads)
+{
+    static std::mt19937 rng{std::random_device{}()};
+
+    std::chrono::milliseconds delay = sspecRetryMin;
+    for (unsigned int i = 1; i < failedReads && delay < sspecRetryMax; i++)
+    {
+        delay *= 2;
+    }
+    delay = std::min<std::chrono::milliseconds>(delay, sspecRetryMax);
+
+    std::uniform_int_distribution<int64_t> jitter(-delay.count() / 4,
+                                                  delay.count() / 4);
+    return delay + std::chrono::milliseconds(jitter(rng));
+}
+
+} // namespace cpu_info
@@ -15,28 +15,49 @@
 #include "speed_select.hpp"
 
 #include "cpuinfo.hpp"
+#include "cpuinfo_cache.hpp"
 #include "cpuinfo_utils.hpp"
+#include "peci_instrumentation.hpp"
+#include "peci_readiness.hpp"
+#include "peci_worker.hpp"
+#include "sst_discovery.hpp"
 
 #include <peci.h>
 
-#include <boost/asio/error.hpp>
 #include <boost/asio/steady_timer.hpp>
+#include <boost/container/flat_map.hpp>
+#include <sdbusplus/asio/object_server.hpp>
 #include <xyz/openbmc_project/Common/Device/error.hpp>
 #include <xyz/openbmc_project/Common/error.hpp>
 #include <xyz/openbmc_project/Control/Processor/CurrentOperatingConfig/server.hpp>
 #include <xyz/openbmc_project/Inventory/Item/Cpu/OperatingConfig/server.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tuple>
 
 namespace cpu_info
 {
 namespace sst
 {
 
+// How often the cached CurrentOperatingConfig properties are re-read from the
+// CPUs, to pick up changes made by in-band software.
+#ifndef SST_REFRESH_INTERVAL
+#define SST_REFRESH_INTERVAL 10
+#endif
+static constexpr std::chrono::seconds refreshInterval{SST_REFRESH_INTERVAL};
+// After consecutive failed refreshes, e.g. while the package is idle and can't
+// be read without waking it, the interval doubles up to this many times.
+static constexpr unsigned int refreshMaxBackoff = 5;
+
 // Specialize char to print the integer value instead of ascii. We basically
 // never want to print a single ascii char.
 std::ostream& operator<<(std::ostream& os, uint8_t value)
@@ -56,17 +77,16 @@ bool checkPECIStatus(EPECIStatus libStatus, uint8_t completionCode)
     return true;
 }
 
-std::vector<uint32_t> convertMaskToList(std::bitset<64> mask)
+bool isSleeping(EPECIStatus libStatus, uint8_t completionCode)
 {
-    std::vector<uint32_t> bitList;
-    for (size_t i = 0; i < mask.size(); ++i)
-    {
-        if (mask.test(i))
-        {
-            bitList.push_back(i);
-        }
-    }
-    return bitList;
+    // PECI completion code defined in peci-ioctl.h which is not available
+    // for us to include.
+    constexpr int PECI_DEV_CC_UNAVAIL_RESOURCE = 0x82;
+    // Observed library returning DRIVER_ERR for reads and TIMEOUT for
+    // writes while PECI is sleeping. Either way, the completion code from
+    // PECI client should be reliable indicator of need to set WOP.
+    return libStatus != PECI_CC_SUCCESS &&
+           completionCode == PECI_DEV_CC_UNAVAIL_RESOURCE;
 }
 
 static std::vector<BackendProvider>& getProviders()
@@ -80,9 +100,52 @@ void registerBackend(BackendProvider providerFn)
     getProviders().push_back(providerFn);
 }
 
+/**
+ * Provider which last succeeded for each CPU model. getInstance() is called
+ * from the PECI worker threads, so the cache is protected by a mutex.
+ */
+static std::mutex providerCacheMutex;
+static boost::container::flat_map<CPUModel, BackendProvider> providerCache;
+
+void invalidateBackendCache()
+{
+    std::lock_guard lock(providerCacheMutex);
+    providerCache.clear();
+}
+
+static std::optional<BackendProvider> getCachedProvider(CPUModel model)
+{
+    std::lock_guard lock(providerCacheMutex);
+    auto it = providerCache.find(model);
+    if (it == providerCache.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
 std::unique_ptr<SSTInterface> getInstance(uint8_t address, CPUModel model,
                                           WakePolicy wakePolicy)
 {
+    if (auto provider = getCachedProvider(model))
+    {
+        try
+        {
+            auto interface = (*provider)(address, model, wakePolicy);
+            if (interface)
+            {
+                return interface;
+            }
+        }
+        catch (...)
+        {
+            // Most likely a PECI failure, which another provider won't fix.
+            return nullptr;
+        }
+        // The provider no longer supports this model, search again.
+        invalidateBackendCache();
+    }
+
     DEBUG_PRINT << "Searching for provider for " << address << ", model "
                 << std::hex << model << std::dec << '\n';
     for (const auto& provider : getProviders())
@@ -93,6 +156,8 @@ std::unique_ptr<SSTInterface> getInstance(uint8_t address, CPUModel model,
             DEBUG_PRINT << "returned " << interface << '\n';
             if (interface)
             {
+                std::lock_guard lock(providerCacheMutex);
+                providerCache.insert_or_assign(model, provider);
                 return interface;
             }
         }
@@ -126,7 +191,15 @@ class OperatingConfig : public BaseOperatingConfig
     {}
 };
 
-class CPUConfig : public BaseCurrentOperatingConfig
+static void publishSingleConfig(const LevelConfig& values,
+                                OperatingConfig& config);
+static void storeCachedLevels(uint8_t address,
+                              const cache::CPUIdentity& identity,
+                              std::vector<LevelConfig> levels);
+
+class CPUConfig :
+    public BaseCurrentOperatingConfig,
+    public std::enable_shared_from_this<CPUConfig>
 {
   private:
     /** Objects describing all available SST configs - not modifiable. */
@@ -136,15 +209,36 @@ class CPUConfig : public BaseCurrentOperatingConfig
     const std::string path; ///< D-Bus path of CPU object
     const CPUModel cpuModel;
 
-    // Keep mutable copies of the properties so we can cache values that we
-    // retrieve in the getters. We don't want to throw an error on a D-Bus
-    // get-property call (extra error handling in clients), so by caching we can
-    // hide any temporary hiccup in PECI communication.
-    // These values can be changed by in-band software so we have to do a full
-    // PECI read on every get-property, and can't assume that values will change
-    // only when set-property is done.
-    mutable unsigned int currentLevel;
-    mutable bool bfEnabled;
+    // The D-Bus properties hold the cached values, so a get-property never
+    // waits on PECI. We don't want to throw an error on a D-Bus get-property
+    // call (extra error handling in clients), so the cache also hides any
+    // temporary hiccup in PECI communication.
+    // These values can be changed by in-band software, so a background
+    // refresher re-reads them periodically and after every set-property, and
+    // emits PropertiesChanged when they differ.
+    unsigned int currentLevel;
+    bool refreshPending = false;
+    /** Consecutive failed refreshes, which back off the refresh interval. */
+    unsigned int refreshFailures = 0;
+    /** Set once a refresh error is logged, until a refresh succeeds. */
+    bool refreshErrorLogged = false;
+    boost::asio::steady_timer refreshTimer;
+
+    // Only the current level is read during discovery. The other levels are
+    // read in a background pass after the objects are published, one at a
+    // time so that other PECI requests don't queue up behind them. Once all
+    // levels are known, they are cached for the next boot.
+    const cache::CPUIdentity identity;
+    /** Values of the levels read so far. */
+    std::vector<LevelConfig> levels;
+    /** Supported levels whose values haven't been read yet. */
+    std::vector<unsigned int> pendingLevels;
+    /**
+     * Backend instance for reading the pending levels, kept between reads so
+     * its caches carry over from discovery. Dropped after a failure, and
+     * once all levels are read, to release its Wake-On-PECI lease.
+     */
+    std::shared_ptr<SSTInterface> levelReader;
 
     /**
      * Enforce common pre-conditions for D-Bus set property handlers.
@@ -159,77 +253,263 @@ class CPUConfig : public BaseCurrentOperatingConfig
         {
             throw sdbusplus::xyz::openbmc_project::Common::Error::Unavailable();
         }
+        if (sst.configLocked())
+        {
+            throw sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed();
+        }
     }
 
-  public:
-    CPUConfig(sdbusplus::bus_t& bus_, uint8_t index, CPUModel model,
-              unsigned int currentLevel_, bool bfEnabled_) :
-        BaseCurrentOperatingConfig(bus_, generatePath(index).c_str(),
-                                   action::defer_emit),
-        bus(bus_), peciAddress(index + MIN_CLIENT_ADDR),
-        path(generatePath(index)), cpuModel(model), currentLevel(currentLevel_),
-        bfEnabled(bfEnabled_)
-    {}
-
-    //
-    // D-Bus Property Overrides
-    //
-
-    sdbusplus::message::object_path appliedConfig() const override
+    /**
+     * Queue a PECI read of the current level and SST-BF state on the PECI
+     * worker, and update the properties once it completes.
+     */
+    void refreshState()
     {
-        DEBUG_PRINT << "Reading AppliedConfig\n";
-        if (hostState != HostState::off)
+        if (hostState == HostState::off || refreshPending)
         {
-            // Otherwise, try to read current state
-            auto sst = getInstance(peciAddress, cpuModel, dontWake);
-            if (!sst || !sst->ready())
-            {
-                std::cerr << __func__
-                          << ": Failed to get SST provider instance\n";
-            }
-            else
-            {
+            return;
+        }
+        refreshPending = true;
+
+        peci::getWorker().post(
+            [address = peciAddress, model = cpuModel]() {
+                auto sst = getInstance(address, model, dontWake);
+                if (!sst || !sst->ready())
+                {
+                    throw PECIError("Failed to get SST provider instance");
+                }
+                unsigned int level = sst->currentLevel();
+                return std::make_tuple(level, sst->bfEnabled(level));
+            },
+            [weak = weak_from_this()](std::exception_ptr err,
+                                      std::tuple<unsigned int, bool> state) {
+                auto self = weak.lock();
+                if (!self)
+                {
+                    return;
+                }
+                self->refreshPending = false;
                 try
                 {
-                    currentLevel = sst->currentLevel();
+                    if (err)
+                    {
+                        std::rethrow_exception(err);
+                    }
+                    self->updateState(std::get<0>(state), std::get<1>(state));
+                    if (self->refreshErrorLogged)
+                    {
+                        std::cerr << "Refreshing SST state of CPU "
+                                  << self->peciAddress - MIN_CLIENT_ADDR
+                                  << " works again\n";
+                    }
+                    self->refreshFailures = 0;
+                    self->refreshErrorLogged = false;
                 }
-                catch (const PECIError& error)
+                catch (const PECISleepingError&)
                 {
-                    std::cerr << "Failed to get SST-PP level: " << error.what()
-                              << "\n";
+                    // The package is idle, and refreshes don't wake it, so
+                    // keep the cached values until it can be read again.
+                    self->refreshFailures++;
                 }
-            }
-        }
-        return generateConfigPath(currentLevel);
+                catch (const std::exception& error)
+                {
+                    if (!self->refreshErrorLogged)
+                    {
+                        std::cerr << "Failed to refresh SST state of CPU "
+                                  << self->peciAddress - MIN_CLIENT_ADDR << ": "
+                                  << error.what() << "\n";
+                        self->refreshErrorLogged = true;
+                    }
+                    self->refreshFailures++;
+                }
+            });
+    }
+
+    /**
+     * Update the cached properties. PropertiesChanged is only emitted for
+     * values which actually changed.
+     */
+    void updateState(unsigned int level, bool bfEnabled,
+                     bool skipSignal = false)
+    {
+        currentLevel = level;
+        BaseCurrentOperatingConfig::appliedConfig(generateConfigPath(level),
+                                                  skipSignal);
+        BaseCurrentOperatingConfig::baseSpeedPriorityEnabled(bfEnabled,
+                                                             skipSignal);
+    }
+
+    /**
+     * Emit PropertiesChanged for AppliedConfig with its cached value, even
+     * though it didn't change. A client which set AppliedConfig then sees the
+     * level the CPU is actually at, if the change failed. The refresh which
+     * follows corrects the value if it was changed in-band meanwhile.
+     */
+    void signalAppliedConfig()
+    {
+        bus.emit_properties_changed(path.c_str(),
+                                    BaseCurrentOperatingConfig::interface,
+                                    std::vector<std::string>{"AppliedConfig"});
     }
 
-    bool baseSpeedPriorityEnabled() const override
+    /** Update the properties of a config from values read from the CPU. */
+    void publishLevel(const LevelConfig& values)
     {
-        DEBUG_PRINT << "Reading BaseSpeedPriorityEnabled\n";
-        if (hostState != HostState::off)
+        for (auto& config : availConfigs)
         {
-            auto sst = getInstance(peciAddress, cpuModel, dontWake);
-            if (!sst || !sst->ready())
+            if (config->level == values.level)
             {
-                std::cerr << __func__
-                          << ": Failed to get SST provider instance\n";
+                publishSingleConfig(values, *config);
             }
-            else
-            {
+        }
+    }
+
+    /**
+     * Queue a PECI read of the next pending level on the PECI worker, and
+     * publish its values once it completes.
+     */
+    void fillNextLevel()
+    {
+        if (pendingLevels.empty() || hostState == HostState::off)
+        {
+            return;
+        }
+
+        using Result = std::tuple<std::shared_ptr<SSTInterface>, LevelConfig>;
+        peci::getWorker().post(
+            [reader = levelReader, address = peciAddress, model = cpuModel,
+             level = pendingLevels.front()]() mutable {
+                if (!reader)
+                {
+                    reader = getInstance(address, model, wakeAllowed);
+                    if (!reader || !reader->ready())
+                    {
+                        throw PECIError("Failed to get SST provider instance");
+                    }
+                }
+                LevelConfig values = discoverLevel(*reader, level);
+                return Result(std::move(reader), std::move(values));
+            },
+            [weak = weak_from_this()](std::exception_ptr err, Result result) {
+                auto self = weak.lock();
+                if (!self)
+                {
+                    return;
+                }
                 try
                 {
-                    bfEnabled = sst->bfEnabled(currentLevel);
+                    if (err)
+                    {
+                        self->levelReader.reset();
+                        std::rethrow_exception(err);
+                    }
                 }
-                catch (const PECIError& error)
+                catch (const boost::system::system_error&)
                 {
-                    std::cerr << "Failed to get SST-BF status: " << error.what()
-                              << "\n";
+                    // Cancelled because the host powered off. Discovery
+                    // replaces this object when it powers back on.
+                    return;
                 }
-            }
+                catch (const std::exception& error)
+                {
+                    std::cerr << "Failed to read SST-PP level "
+                              << self->pendingLevels.front() << " of CPU "
+                              << self->peciAddress - MIN_CLIENT_ADDR << ": "
+                              << error.what() << "\n";
+                    peci::retryWhenReady(self->peciAddress,
+                                         [weak](bool present) {
+                                             auto self = weak.lock();
+                                             if (self && present)
+                                             {
+                                                 self->fillNextLevel();
+                                             }
+                                         });
+                    return;
+                }
+                peci::confirmReady(self->peciAddress);
+                self->levelReader = std::move(std::get<0>(result));
+                self->levelFilled(std::move(std::get<1>(result)));
+            });
+    }
+
+    void levelFilled(LevelConfig values)
+    {
+        std::erase(pendingLevels, values.level);
+        publishLevel(values);
+        levels.push_back(std::move(values));
+        if (pendingLevels.empty())
+        {
+            levelReader.reset();
+            storeCachedLevels(peciAddress, identity, levels);
+            return;
+        }
+        fillNextLevel();
+    }
+
+    /**
+     * Schedule the next periodic refresh, backing off while refreshes keep
+     * failing.
+     */
+    void scheduleRefresh()
+    {
+        refreshTimer.expires_after(
+            refreshInterval *
+            (1U << std::min(refreshFailures, refreshMaxBackoff)));
+        refreshTimer.async_wait(
+            [weak = weak_from_this()](boost::system::error_code ec) {
+                auto self = weak.lock();
+                if (ec || !self)
+                {
+                    return;
+                }
+                self->refreshState();
+                self->scheduleRefresh();
+            });
+    }
+
+  public:
+    CPUConfig(sdbusplus::bus_t& bus_, const CPUDiscovery& info) :
+        BaseCurrentOperatingConfig(bus_, generatePath(info.index).c_str(),
+                                   action::defer_emit),
+        bus(bus_), peciAddress(info.index + MIN_CLIENT_ADDR),
+        path(generatePath(info.index)), cpuModel(info.model),
+        currentLevel(info.currentLevel), refreshTimer(dbus::getIOContext()),
+        identity(info.identity), levels(info.levels),
+        pendingLevels(info.pendingLevels), levelReader(info.sst)
+    {
+        updateState(info.currentLevel, info.bfEnabled, true);
+
+        std::vector<unsigned int> available = pendingLevels;
+        for (const LevelConfig& values : levels)
+        {
+            available.push_back(values.level);
+        }
+        std::ranges::sort(available);
+        for (unsigned int level : available)
+        {
+            newConfig(level);
+        }
+        for (const LevelConfig& values : levels)
+        {
+            publishLevel(values);
         }
-        return bfEnabled;
     }
 
+    //
+    // D-Bus Property Overrides
+    //
+
+    /**
+     * Set-property handler for AppliedConfig. The requested config and the
+     * pre-conditions, including the BIOS lock of the SST-PP config, are
+     * checked right away, and errors there fail the Set. The level change
+     * itself is queued on the PECI worker, so the D-Bus handler doesn't wait
+     * for it, and a successful Set only means the change was accepted. Once it completes, the state is read back and
+     * PropertiesChanged reports the new AppliedConfig. If the change fails,
+     * PropertiesChanged is emitted anyway, with the level the CPU is still at.
+     * Clients which need to know whether the change succeeded should use
+     * ApplyOperatingConfig instead.
+     */
     sdbusplus::message::object_path
         appliedConfig(sdbusplus::message::object_path value) override
     {
@@ -253,21 +533,36 @@ class CPUConfig : public BaseCurrentOperatingConfig
         if (!sst)
         {
             std::cerr << __func__ << ": Failed to get SST provider instance\n";
-            return sdbusplus::message::object_path();
-        }
-        try
-        {
-            setPropertyCheckOrThrow(*sst);
-            sst->setCurrentLevel(newConfig->level);
-            currentLevel = newConfig->level;
-        }
-        catch (const PECIError& error)
-        {
-            std::cerr << "Failed to set new SST-PP level: " << error.what()
-                      << "\n";
-            throw sdbusplus::xyz::openbmc_project::Common::Device::Error::
-                WriteFailure();
+            throw sdbusplus::xyz::openbmc_project::Common::Error::Unavailable();
         }
+        setPropertyCheckOrThrow(*sst);
+
+        peci::getWorker().post(
+            [sst = std::shared_ptr<SSTInterface>(std::move(sst)),
+             level = newConfig->level]() { sst->setCurrentLevel(level); },
+            [weak = weak_from_this()](std::exception_ptr err) {
+                auto self = weak.lock();
+                try
+                {
+                    if (err)
+                    {
+                        std::rethrow_exception(err);
+                    }
+                }
+                catch (const std::exception& error)
+                {
+                    std::cerr << "Failed to set new SST-PP level: "
+                              << error.what() << "\n";
+                    if (self)
+                    {
+                        self->signalAppliedConfig();
+                    }
+                }
+                if (self)
+                {
+                    self->refreshState();
+                }
+            });
 
         // return value not used
         return sdbusplus::message::object_path();
@@ -309,42 +604,159 @@ class CPUConfig : public BaseCurrentOperatingConfig
         {
             config->emit_added();
         }
+        scheduleRefresh();
+        fillNextLevel();
     }
 
     static std::string generatePath(int index)
     {
         return cpuPath + std::to_string(index);
     }
+
+    uint8_t address() const
+    {
+        return peciAddress;
+    }
+
+    CPUModel model() const
+    {
+        return cpuModel;
+    }
+
+    /** Return whether the given level is one of the available configs. */
+    bool hasLevel(unsigned int level) const
+    {
+        return std::ranges::any_of(availConfigs, [level](const auto& config) {
+            return config->level == level;
+        });
+    }
+
+    /** Re-read the current state after it was changed behind our back. */
+    void refresh()
+    {
+        refreshState();
+    }
 };
 
+void to_json(nlohmann::json& j, const LevelConfig& config)
+{
+    j = nlohmann::json{
+        {"level", config.level},
+        {"powerLimit", config.powerLimit},
+        {"availableCoreCount", config.availableCoreCount},
+        {"baseSpeed", config.baseSpeed},
+        {"maxSpeed", config.maxSpeed},
+        {"maxJunctionTemperature", config.maxJunctionTemperature},
+        {"baseSpeedPrioritySettings", config.baseSpeedPrioritySettings},
+        {"turboProfile", config.turboProfile}};
+}
+
+void from_json(const nlohmann::json& j, LevelConfig& config)
+{
+    j.at("level").get_to(config.level);
+    j.at("powerLimit").get_to(config.powerLimit);
+    j.at("availableCoreCount").get_to(config.availableCoreCount);
+    j.at("baseSpeed").get_to(config.baseSpeed);
+    j.at("maxSpeed").get_to(config.maxSpeed);
+    j.at("maxJunctionTemperature").get_to(config.maxJunctionTemperature);
+    j.at("baseSpeedPrioritySettings").get_to(config.baseSpeedPrioritySettings);
+    j.at("turboProfile").get_to(config.turboProfile);
+}
+
+/** Name of the SST section in the per-socket cache file. */
+static constexpr std::string_view cacheSection = "sst";
+
 /**
- * Retrieve the SST parameters for a single config and fill the values into the
- * properties on the D-Bus interface.
+ * Cache the values of all levels of a CPU, for loadCachedLevels. CPUs without
+ * a PPIN aren't cached.
+ *
+ * @param[in]   address     PECI address of the socket.
+ * @param[in]   identity    Identity of the CPU in the socket.
+ * @param[in]   levels      Values of all supported levels.
+ */
+static void storeCachedLevels(uint8_t address,
+                              const cache::CPUIdentity& identity,
+                              std::vector<LevelConfig> levels)
+{
+    if (identity.ppin == 0)
+    {
+        return;
+    }
+    std::ranges::sort(levels, {}, &LevelConfig::level);
+    cache::store(address, cacheSection,
+                 {{"identity", identity}, {"levels", levels}});
+}
+
+/**
+ * Load the per-level configs cached for a socket by an earlier discovery. The
+ * per-level values are fixed for a given part, so they can be reused as long
+ * as the same CPU is still installed.
+ *
+ * @param[in]   address     PECI address of the socket.
+ * @param[in]   identity    Identity of the CPU currently in the socket.
+ *
+ * @return  Cached configs, or nullopt if there are none for this CPU.
+ */
+static std::optional<std::vector<LevelConfig>>
+    loadCachedLevels(uint8_t address, const cache::CPUIdentity& identity)
+{
+    // Without a PPIN, a different part of the same SKU can't be detected.
+    if (identity.ppin == 0)
+    {
+        return std::nullopt;
+    }
+
+    std::optional<nlohmann::json> cached = cache::load(address, cacheSection);
+    if (!cached)
+    {
+        return std::nullopt;
+    }
+    try
+    {
+        if (cached->at("identity").get<cache::CPUIdentity>() != identity)
+        {
+            DEBUG_PRINT << "CPU identity changed, ignoring cached configs\n";
+            return std::nullopt;
+        }
+        return cached->at("levels").get<std::vector<LevelConfig>>();
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        std::cerr << "Invalid SST cache for CPU " << address - MIN_CLIENT_ADDR
+                  << ": " << e.what() << '\n';
+        return std::nullopt;
+    }
+}
+
+/**
+ * Retrieve the SST parameters for a single config.
  *
  * @param[in,out]   sst         Interface to SST backend.
  * @param[in]       level       Config TDP level to retrieve.
- * @param[out]      config      D-Bus interface to update.
+ *
+ * @return  Values of the config level.
  */
-static void getSingleConfig(SSTInterface& sst, unsigned int level,
-                            OperatingConfig& config)
+static LevelConfig getSingleConfig(SSTInterface& sst, unsigned int level)
 {
-    config.powerLimit(sst.tdp(level));
-    DEBUG_PRINT << " TDP = " << config.powerLimit() << '\n';
+    LevelConfig config{};
+    config.level = level;
 
-    config.availableCoreCount(sst.coreCount(level));
-    DEBUG_PRINT << " coreCount = " << config.availableCoreCount() << '\n';
+    config.powerLimit = sst.tdp(level);
+    DEBUG_PRINT << " TDP = " << config.powerLimit << '\n';
 
-    config.baseSpeed(sst.p1Freq(level));
-    DEBUG_PRINT << " baseSpeed = " << config.baseSpeed() << '\n';
+    config.availableCoreCount = sst.coreCount(level);
+    DEBUG_PRINT << " coreCount = " << config.availableCoreCount << '\n';
 
-    config.maxSpeed(sst.p0Freq(level));
-    DEBUG_PRINT << " maxSpeed = " << config.maxSpeed() << '\n';
+    config.baseSpeed = sst.p1Freq(level);
+    DEBUG_PRINT << " baseSpeed = " << config.baseSpeed << '\n';
 
-    config.maxJunctionTemperature(sst.prochotTemp(level));
-    DEBUG_PRINT << " procHot = " << config.maxJunctionTemperature() << '\n';
+    config.maxSpeed = sst.p0Freq(level);
+    DEBUG_PRINT << " maxSpeed = " << config.maxSpeed << '\n';
+
+    config.maxJunctionTemperature = sst.prochotTemp(level);
+    DEBUG_PRINT << " procHot = " << config.maxJunctionTemperature << '\n';
 
     // Construct BaseSpeedPrioritySettings
-    std::vector<std::tuple<uint32_t, std::vector<uint32_t>>> baseSpeeds;
     if (sst.bfSupported(level))
     {
         std::vector<uint32_t> totalCoreList, loFreqCoreList, hiFreqCoreList;
@@ -355,200 +767,376 @@ static void getSingleConfig(SSTInterface& sst, unsigned int level,
             hiFreqCoreList.end(),
             std::inserter(loFreqCoreList, loFreqCoreList.begin()));
 
-        baseSpeeds = {{sst.bfHighPriorityFreq(level), hiFreqCoreList},
-                      {sst.bfLowPriorityFreq(level), loFreqCoreList}};
+        config.baseSpeedPrioritySettings = {
+            {sst.bfHighPriorityFreq(level), hiFreqCoreList},
+            {sst.bfLowPriorityFreq(level), loFreqCoreList}};
     }
-    config.baseSpeedPrioritySettings(baseSpeeds);
 
-    config.turboProfile(sst.sseTurboProfile(level));
+    config.turboProfile = sst.sseTurboProfile(level);
+    return config;
 }
 
 /**
- * Retrieve all SST configuration info for all discoverable CPUs, and publish
- * the info on new D-Bus objects on the given bus connection.
- *
- * @param[in,out]   ioc     ASIO context.
- * @param[in,out]   conn    D-Bus ASIO connection.
+ * Fill the values of a single config into the properties on its D-Bus
+ * interface.
  *
- * @return  Whether discovery was successfully finished.
- *
- * @throw PECIError     A PECI command failed on a CPU which had previously
- *                      responded to a command.
+ * @param[in]   values  Values read from the CPU.
+ * @param[out]  config  D-Bus interface to update.
  */
-static bool discoverCPUsAndConfigs(boost::asio::io_context& ioc,
-                                   sdbusplus::asio::connection& conn)
+static void publishSingleConfig(const LevelConfig& values,
+                                OperatingConfig& config)
 {
-    // Persistent list - only populated after complete/successful discovery
-    static std::vector<std::unique_ptr<CPUConfig>> cpus;
-    cpus.clear();
+    config.powerLimit(values.powerLimit);
+    config.availableCoreCount(values.availableCoreCount);
+    config.baseSpeed(values.baseSpeed);
+    config.maxSpeed(values.maxSpeed);
+    config.maxJunctionTemperature(values.maxJunctionTemperature);
+    config.baseSpeedPrioritySettings(values.baseSpeedPrioritySettings);
+    config.turboProfile(values.turboProfile);
+}
+
+SocketDiscovery discoverCPU(uint8_t address, std::stop_token stop)
+{
+    unsigned int cpuIndex = address - MIN_CLIENT_ADDR;
+    DEBUG_PRINT << "Discovering CPU " << cpuIndex << '\n';
+
+    // We could possibly check D-Bus for CPU presence and model, but PECI is
+    // 10x faster and so much simpler.
+    uint8_t cc, stepping;
+    CPUModel cpuModel;
+    EPECIStatus status = peci::getCPUID(address, &cpuModel, &stepping, &cc);
+    if (status == PECI_CC_TIMEOUT)
+    {
+        // Timing out indicates the CPU is present but PCS services not
+        // working yet. Try again later.
+        throw PECIError("Get CPUID timed out");
+    }
+    if (status == PECI_CC_CPU_NOT_PRESENT)
+    {
+        return {SocketStatus::absent, {}};
+    }
+    if (status != PECI_CC_SUCCESS || cc != PECI_DEV_CC_SUCCESS)
+    {
+        std::cerr << "GetCPUID returned status " << status << ", cc = " << cc
+                  << '\n';
+        return {SocketStatus::absent, {}};
+    }
 
-    // Temporary staging list. In case there is any failure, these temporary
-    // objects will get dropped to avoid presenting incomplete info until the
-    // next discovery attempt.
-    std::vector<std::unique_ptr<CPUConfig>> cpuList;
+    std::shared_ptr<SSTInterface> sst =
+        getInstance(address, cpuModel, wakeAllowed);
 
-    for (uint8_t i = MIN_CLIENT_ADDR; i <= MAX_CLIENT_ADDR; ++i)
+    if (!sst)
     {
-        // Let the event handler run any waiting tasks. If there is a lot of
-        // PECI contention, SST discovery could take a long time. This lets us
-        // get updates to hostState and handle any D-Bus requests.
-        ioc.poll();
+        // No supported backend for this CPU.
+        return {SocketStatus::absent, {}};
+    }
 
-        if (hostState == HostState::off)
-        {
-            return false;
-        }
+    if (!sst->ready())
+    {
+        // Supported CPU but it can't be queried yet. Try again later.
+        std::cerr << "sst not ready yet\n";
+        return {SocketStatus::notReady, {}};
+    }
 
-        unsigned int cpuIndex = i - MIN_CLIENT_ADDR;
-        DEBUG_PRINT << "Discovering CPU " << cpuIndex << '\n';
+    if (!sst->ppEnabled())
+    {
+        // Supported CPU but the specific SKU doesn't support SST-PP.
+        std::cerr << "CPU doesn't support SST-PP\n";
+        return {SocketStatus::absent, {}};
+    }
 
-        // We could possibly check D-Bus for CPU presence and model, but PECI is
-        // 10x faster and so much simpler.
-        uint8_t cc, stepping;
-        CPUModel cpuModel;
-        EPECIStatus status = peci_GetCPUID(i, &cpuModel, &stepping, &cc);
-        if (status == PECI_CC_TIMEOUT)
+    unsigned int currentLevel = sst->currentLevel();
+    CPUDiscovery cpu{cpuIndex, cpuModel, currentLevel,
+                     sst->bfEnabled(currentLevel), {}, {}, {}, {}};
+    std::optional<uint64_t> ppin = cache::readPPIN(address, cpuModel);
+    if (!ppin)
+    {
+        // The PPIN keys the level cache, so don't guess at it.
+        throw PECIError("Failed to read PPIN");
+    }
+    cpu.identity = {cpuModel, stepping, *ppin};
+
+    // If this is the same CPU as last time, skip reading the levels.
+    if (auto cached = loadCachedLevels(address, cpu.identity))
+    {
+        if (std::ranges::any_of(*cached, [&cpu](const LevelConfig& c) {
+                return c.level == cpu.currentLevel;
+            }))
         {
-            // Timing out indicates the CPU is present but PCS services not
-            // working yet. Try again later.
-            throw PECIError("Get CPUID timed out");
+            DEBUG_PRINT << "Using cached configs for CPU " << cpuIndex << '\n';
+            cpu.levels = std::move(*cached);
+            return {SocketStatus::discovered, std::move(cpu)};
         }
-        if (status == PECI_CC_CPU_NOT_PRESENT)
+    }
+
+    std::vector<unsigned int> supportedLevels;
+    for (unsigned int level = 0; level <= sst->maxLevel(); ++level)
+    {
+        if (stop.stop_requested())
         {
-            continue;
+            return {SocketStatus::notReady, {}};
         }
-        if (status != PECI_CC_SUCCESS || cc != PECI_DEV_CC_SUCCESS)
+
+        DEBUG_PRINT << "checking level " << level << ": ";
+        // levels 1 and 2 were legacy/deprecated, originally used for AVX
+        // license pre-granting. They may be reused for more levels in
+        // future generations. So we need to check for discontinuities.
+        if (!sst->levelSupported(level))
         {
-            std::cerr << "GetCPUID returned status " << status
-                      << ", cc = " << cc << '\n';
+            DEBUG_PRINT << "not supported\n";
             continue;
         }
 
-        std::unique_ptr<SSTInterface> sst =
-            getInstance(i, cpuModel, wakeAllowed);
+        DEBUG_PRINT << "supported\n";
+        supportedLevels.push_back(level);
+    }
 
-        if (!sst)
-        {
-            // No supported backend for this CPU.
-            continue;
-        }
+    DEBUG_PRINT << "current level is " << currentLevel << '\n';
 
-        if (!sst->ready())
-        {
-            // Supported CPU but it can't be queried yet. Try again later.
-            std::cerr << "sst not ready yet\n";
-            return false;
-        }
+    if (std::ranges::find(supportedLevels, currentLevel) ==
+        supportedLevels.end())
+    {
+        // In case we didn't encounter a PECI error, but also didn't find
+        // the config which is supposedly applied, we won't be able to
+        // populate the CurrentOperatingConfig so we have to remove this CPU
+        // from consideration.
+        std::cerr << "CPU " << cpuIndex
+                  << " claimed SST support but invalid configs\n";
+        return {SocketStatus::absent, {}};
+    }
 
-        if (!sst->ppEnabled())
+    cpu.levels.push_back(getSingleConfig(*sst, currentLevel));
+    for (unsigned int level : supportedLevels)
+    {
+        if (level != currentLevel)
         {
-            // Supported CPU but the specific SKU doesn't support SST-PP.
-            std::cerr << "CPU doesn't support SST-PP\n";
-            continue;
+            cpu.pendingLevels.push_back(level);
         }
+    }
+    if (cpu.pendingLevels.empty())
+    {
+        storeCachedLevels(address, cpu.identity, cpu.levels);
+    }
+    else
+    {
+        // Publishing waits for the other sockets, so don't keep the CPU awake
+        // meanwhile.
+        sst->idle();
+        cpu.sst = std::move(sst);
+    }
 
-        // Create the per-CPU configuration object
-        unsigned int currentLevel = sst->currentLevel();
-        cpuList.emplace_back(
-            std::make_unique<CPUConfig>(conn, cpuIndex, cpuModel, currentLevel,
-                                        sst->bfEnabled(currentLevel)));
-        CPUConfig& cpu = *cpuList.back();
+    return {SocketStatus::discovered, std::move(cpu)};
+}
 
-        bool foundCurrentLevel = false;
+LevelConfig discoverLevel(SSTInterface& sst, unsigned int level)
+{
+    return getSingleConfig(sst, level);
+}
 
-        for (unsigned int level = 0; level <= sst->maxLevel(); ++level)
-        {
-            DEBUG_PRINT << "checking level " << level << ": ";
-            // levels 1 and 2 were legacy/deprecated, originally used for AVX
-            // license pre-granting. They may be reused for more levels in
-            // future generations. So we need to check for discontinuities.
-            if (!sst->levelSupported(level))
-            {
-                DEBUG_PRINT << "not supported\n";
-                continue;
-            }
+/**
+ * Persistent list of CPU objects - only populated after complete/successful
+ * discovery.
+ */
+static std::vector<std::shared_ptr<CPUConfig>> publishedCPUs;
 
-            DEBUG_PRINT << "supported\n";
+/**
+ * Publish the discovered SST info on new D-Bus objects, replacing any objects
+ * from a previous discovery.
+ *
+ * @param[in,out]   conn        D-Bus ASIO connection.
+ * @param[in]       discovered  Results of a complete, successful discovery.
+ */
+static void publishCPUs(sdbusplus::asio::connection& conn,
+                        const std::vector<CPUDiscovery>& discovered)
+{
+    std::vector<std::shared_ptr<CPUConfig>>& cpus = publishedCPUs;
+    cpus.clear();
 
-            getSingleConfig(*sst, level, cpu.newConfig(level));
+    for (const CPUDiscovery& info : discovered)
+    {
+        cpus.push_back(std::make_shared<CPUConfig>(conn, info));
+    }
 
-            if (level == currentLevel)
-            {
-                foundCurrentLevel = true;
-            }
-        }
+    std::for_each(cpus.begin(), cpus.end(), [](auto& cpu) { cpu->finalize(); });
+}
 
-        DEBUG_PRINT << "current level is " << currentLevel << '\n';
+/**
+ * State of the discovery since the host last powered on. Sockets are
+ * discovered independently, each retried as soon as its CPU responds again,
+ * and sockets which finished are kept staged meanwhile. Nothing is published
+ * until every socket is done.
+ */
+struct DiscoveryState
+{
+    /** Results of sockets which finished. */
+    std::vector<CPUDiscovery> staged;
+    /** Sockets which haven't finished yet. */
+    unsigned int outstanding = 0;
+    /** Set when the discovery was cancelled. */
+    bool cancelled = false;
+};
 
-        if (!foundCurrentLevel)
-        {
-            // In case we didn't encounter a PECI error, but also didn't find
-            // the config which is supposedly applied, we won't be able to
-            // populate the CurrentOperatingConfig so we have to remove this CPU
-            // from consideration.
-            std::cerr << "CPU " << cpuIndex
-                      << " claimed SST support but invalid configs\n";
-            cpuList.pop_back();
-            continue;
-        }
+static void discoverSocket(const std::shared_ptr<DiscoveryState>& state,
+                           uint8_t address);
+
+/**
+ * Mark one socket as finished, and publish the results once all of them are.
+ */
+static void socketFinished(const std::shared_ptr<DiscoveryState>& state)
+{
+    if (--state->outstanding > 0)
+    {
+        return;
     }
 
-    cpuList.swap(cpus);
-    std::for_each(cpus.begin(), cpus.end(), [](auto& cpu) { cpu->finalize(); });
-    return true;
+    DEBUG_PRINT << "Finished discovery\n";
+
+    if (state->cancelled || hostState == HostState::off)
+    {
+        return;
+    }
+
+    std::sort(state->staged.begin(), state->staged.end(),
+              [](const CPUDiscovery& a, const CPUDiscovery& b) {
+                  return a.index < b.index;
+              });
+    publishCPUs(*dbus::getConnection(), state->staged);
 }
 
 /**
- * Attempt discovery process, and if it fails, wait for 10 seconds to try again.
+ * Discover the socket again once its CPU responds to PECI again.
  */
-static void discoverOrWait()
+static void retrySocket(const std::shared_ptr<DiscoveryState>& state,
+                        uint8_t address)
 {
-    static boost::asio::steady_timer peciRetryTimer(dbus::getIOContext());
-    static int peciErrorCount = 0;
-    bool finished = false;
+    peci::retryWhenReady(address, [state, address](bool present) {
+        if (state->cancelled || hostState == HostState::off)
+        {
+            return;
+        }
+        if (!present)
+        {
+            socketFinished(state);
+            return;
+        }
+        discoverSocket(state, address);
+    });
+}
 
-    // This function may be called from hostStateHandler or by retrying itself.
-    // In case those overlap, cancel any outstanding retry timer.
-    peciRetryTimer.cancel();
+/**
+ * Discovery errors of each socket. In case of repeated failure to finish
+ * discovery on one socket, give up on just that socket until it is discovered
+ * successfully or the host powers on again. Possible cause is that the CPU
+ * model does not actually support the necessary commands.
+ */
+static boost::container::flat_map<uint8_t, int> peciErrorCount;
 
+/**
+ * Handle the result of discovering one socket.
+ */
+static void socketDiscovered(const std::shared_ptr<DiscoveryState>& state,
+                             uint8_t address, std::exception_ptr err,
+                             SocketDiscovery result)
+{
     try
     {
-        DEBUG_PRINT << "Starting discovery\n";
-        finished = discoverCPUsAndConfigs(dbus::getIOContext(),
-                                          *dbus::getConnection());
+        if (err)
+        {
+            std::rethrow_exception(err);
+        }
+        switch (result.status)
+        {
+            case SocketStatus::absent:
+                break;
+            case SocketStatus::notReady:
+                retrySocket(state, address);
+                return;
+            case SocketStatus::discovered:
+                peci::confirmReady(address);
+                peciErrorCount.erase(address);
+                state->staged.push_back(std::move(result.cpu));
+                break;
+        }
+    }
+    catch (const boost::system::system_error&)
+    {
+        // Cancelled because the host powered off. Discovery is started again
+        // when it powers back on.
+        state->cancelled = true;
     }
-    catch (const PECIError& err)
+    catch (const PECIError& error)
     {
-        std::cerr << "PECI Error: " << err.what() << '\n';
+        std::cerr << "PECI Error on CPU " << address - MIN_CLIENT_ADDR << ": "
+                  << error.what() << '\n';
 
-        // In case of repeated failure to finish discovery, turn off this
-        // feature altogether. Possible cause is that the CPU model does not
-        // actually support the necessary commands.
-        if (++peciErrorCount >= 50)
+        if (++peciErrorCount[address] >= 50)
+        {
+            std::cerr << "Aborting SST discovery on CPU "
+                      << address - MIN_CLIENT_ADDR << "\n";
+        }
+        else
         {
-            std::cerr << "Aborting SST discovery\n";
+            std::cerr << "Retrying SST discovery later\n";
+            retrySocket(state, address);
             return;
         }
-
-        std::cerr << "Retrying SST discovery later\n";
     }
 
-    DEBUG_PRINT << "Finished discovery attempt: " << finished << '\n';
+    socketFinished(state);
+}
+
+/**
+ * Queue discovery of one socket on the PECI worker. The worker bounds how
+ * many sockets are discovered at once.
+ */
+static void discoverSocket(const std::shared_ptr<DiscoveryState>& state,
+                           uint8_t address)
+{
+    DEBUG_PRINT << "Starting discovery of CPU " << address - MIN_CLIENT_ADDR
+                << "\n";
+    peci::getWorker().post(
+        [address](std::stop_token stop) {
+            return discoverCPU(address, std::move(stop));
+        },
+        [state, address](std::exception_ptr err, SocketDiscovery result) {
+            socketDiscovered(state, address, err, std::move(result));
+        });
+}
+
+/**
+ * Start discovery from scratch on all sockets. Each socket is discovered as
+ * soon as its CPU responds to PECI, and skipped if the socket is empty.
+ */
+static void startDiscovery()
+{
+    static std::shared_ptr<DiscoveryState> state;
+
+    // Any discovery still in flight belongs to the previous power cycle.
+    if (state)
+    {
+        state->cancelled = true;
+    }
+    if (hostState == HostState::off)
+    {
+        return;
+    }
 
-    // Retry later if no CPUs were available, or there was a PECI error.
-    if (!finished)
+    state = std::make_shared<DiscoveryState>();
+    state->outstanding = MAX_CLIENT_ADDR - MIN_CLIENT_ADDR + 1;
+    for (uint8_t address = MIN_CLIENT_ADDR; address <= MAX_CLIENT_ADDR;
+         address++)
     {
-        peciRetryTimer.expires_after(std::chrono::seconds(10));
-        peciRetryTimer.async_wait([](boost::system::error_code ec) {
-            if (ec)
+        peci::whenReady(address, [state = state, address](bool present) {
+            if (state->cancelled || hostState == HostState::off)
             {
-                if (ec != boost::asio::error::operation_aborted)
-                {
-                    std::cerr << "SST PECI Retry Timer failed: " << ec << '\n';
-                }
                 return;
             }
-            discoverOrWait();
+            if (!present)
+            {
+                socketFinished(state);
+                return;
+            }
+            discoverSocket(state, address);
         });
     }
 }
@@ -558,14 +1146,366 @@ static void hostStateHandler(HostState prevState, HostState)
     if (prevState == HostState::off)
     {
         // Start or re-start discovery any time the host moves out of the
-        // powered off state.
-        discoverOrWait();
+        // powered off state. The CPUs may have been swapped while the host
+        // was off, so resolve the backends again too, and give every socket
+        // its full error budget.
+        invalidateBackendCache();
+        peciErrorCount.clear();
+        startDiscovery();
+    }
+}
+
+static constexpr const char* speedSelectInterface =
+    "xyz.openbmc_project.CPUInfo.SpeedSelect";
+static constexpr const char* applyCompleteSignal =
+    "ApplyOperatingConfigComplete";
+
+/** Progress and outcome of ApplyOperatingConfig on one socket. */
+struct SocketApply
+{
+    uint8_t address;
+    CPUModel model;
+    ControlChange change;
+    /** Empty on success. */
+    std::string error;
+    std::chrono::microseconds duration{};
+};
+
+/** State of one ApplyOperatingConfig call. */
+struct ApplyRequest
+{
+    uint64_t id;
+    unsigned int level;
+    std::optional<bool> bfEnabled;
+    std::optional<bool> tfEnabled;
+    std::vector<SocketApply> sockets;
+    /** Per-socket result reported in the completion signal. */
+    std::vector<std::string> results;
+    unsigned int outstanding = 0;
+};
+
+/** At most one ApplyOperatingConfig may be in progress. */
+static std::shared_ptr<ApplyRequest> activeApply;
+static std::shared_ptr<sdbusplus::asio::dbus_interface> speedSelectIface;
+
+void applyConfig(uint8_t address, CPUModel model, unsigned int level,
+                 std::optional<bool> bfEnabled, std::optional<bool> tfEnabled,
+                 ControlChange& change)
+{
+    auto sst = getInstance(address, model, wakeAllowed);
+    if (!sst || !sst->ready() || !sst->supportsControl())
+    {
+        throw PECIError("SST control not available");
+    }
+    if (sst->configLocked())
+    {
+        throw PECIError("SST-PP config is locked");
+    }
+
+    ControlState& previous = change.previous;
+    previous.level = sst->currentLevel();
+    previous.bfEnabled = sst->bfEnabled(previous.level);
+    previous.tfEnabled = sst->tfEnabled(previous.level);
+
+    if (bfEnabled.value_or(false) && !sst->bfSupported(level))
+    {
+        throw PECIError("SST-BF not supported by level");
+    }
+    if (tfEnabled.value_or(false) && !sst->tfSupported(level))
+    {
+        throw PECIError("SST-TF not supported by level");
+    }
+
+    if (level != previous.level)
+    {
+        change.modified = true;
+        sst->setCurrentLevel(level);
+    }
+    // SST-BF and SST-TF are set together, so the one which isn't requested is
+    // written back with its current state.
+    bool bf = bfEnabled ? *bfEnabled : sst->bfEnabled(level);
+    bool tf = tfEnabled ? *tfEnabled : sst->tfEnabled(level);
+    if (bfEnabled || tfEnabled)
+    {
+        change.modified = true;
+        sst->setBfTfEnabled(bf, tf);
+    }
+
+    // Read back with a fresh instance, so nothing is answered from the old
+    // instance's mailbox cache.
+    auto check = getInstance(address, model, wakeAllowed);
+    if (!check || check->currentLevel() != level)
+    {
+        throw PECIError("Level was not applied");
+    }
+    if (check->bfEnabled(level) != bf)
+    {
+        throw PECIError("SST-BF state was not applied");
+    }
+    if (check->tfEnabled(level) != tf)
+    {
+        throw PECIError("SST-TF state was not applied");
+    }
+}
+
+void restoreConfig(uint8_t address, CPUModel model, const ControlState& state)
+{
+    auto sst = getInstance(address, model, wakeAllowed);
+    if (!sst)
+    {
+        throw PECIError("Failed to get SST provider instance");
+    }
+    if (sst->currentLevel() != state.level)
+    {
+        sst->setCurrentLevel(state.level);
+    }
+    if (sst->bfEnabled(state.level) != state.bfEnabled ||
+        sst->tfEnabled(state.level) != state.tfEnabled)
+    {
+        sst->setBfTfEnabled(state.bfEnabled, state.tfEnabled);
     }
 }
 
-void init()
+/**
+ * Apply the requested config to one socket and verify the result. This only
+ * talks to PECI, and is meant to run on a PECI worker thread.
+ */
+static SocketApply applyToSocket(SocketApply socket, unsigned int level,
+                                 std::optional<bool> bfEnabled,
+                                 std::optional<bool> tfEnabled)
+{
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        applyConfig(socket.address, socket.model, level, bfEnabled, tfEnabled,
+                    socket.change);
+    }
+    catch (const std::exception& e)
+    {
+        socket.error = e.what();
+    }
+    socket.duration = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    return socket;
+}
+
+/**
+ * Report the outcome of the request, and refresh the affected CPU objects.
+ */
+static void finishApply(const std::shared_ptr<ApplyRequest>& request)
+{
+    bool success = std::ranges::all_of(
+        request->sockets,
+        [](const SocketApply& socket) { return socket.error.empty(); });
+
+    // (socket index, result, error, apply duration in microseconds)
+    std::vector<std::tuple<uint32_t, std::string, std::string, uint64_t>>
+        results;
+    for (size_t i = 0; i < request->sockets.size(); i++)
+    {
+        const SocketApply& socket = request->sockets[i];
+        results.emplace_back(socket.address - MIN_CLIENT_ADDR,
+                             request->results[i], socket.error,
+                             socket.duration.count());
+        std::cerr << "SST apply " << request->id << " on CPU "
+                  << socket.address - MIN_CLIENT_ADDR << ": "
+                  << request->results[i] << " in " << socket.duration.count()
+                  << "us" << (socket.error.empty() ? "" : ": ") << socket.error
+                  << '\n';
+    }
+
+    if (speedSelectIface)
+    {
+        sdbusplus::message_t msg =
+            speedSelectIface->new_signal(applyCompleteSignal);
+        msg.append(request->id, success, results);
+        msg.signal_send();
+    }
+
+    for (auto& cpu : publishedCPUs)
+    {
+        cpu->refresh();
+    }
+    if (activeApply == request)
+    {
+        activeApply.reset();
+    }
+}
+
+/**
+ * Called once every socket finished applying. If any of them failed, roll
+ * back all sockets which were modified.
+ */
+static void applyDone(const std::shared_ptr<ApplyRequest>& request)
+{
+    bool failed = std::ranges::any_of(
+        request->sockets,
+        [](const SocketApply& socket) { return !socket.error.empty(); });
+
+    for (size_t i = 0; i < request->sockets.size(); i++)
+    {
+        const SocketApply& socket = request->sockets[i];
+        request->results[i] = socket.error.empty() ? "Applied" : "Failed";
+    }
+    if (!failed)
+    {
+        finishApply(request);
+        return;
+    }
+
+    request->outstanding = 0;
+    for (size_t i = 0; i < request->sockets.size(); i++)
+    {
+        const SocketApply& socket = request->sockets[i];
+        if (!socket.change.modified)
+        {
+            continue;
+        }
+        request->outstanding++;
+        peci::getWorker().post(
+            [address = socket.address, model = socket.model,
+             previous = socket.change.previous]() {
+                restoreConfig(address, model, previous);
+            },
+            [request, i](std::exception_ptr err) {
+                request->results[i] = "RolledBack";
+                try
+                {
+                    if (err)
+                    {
+                        std::rethrow_exception(err);
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    request->results[i] = "RollbackFailed";
+                    std::cerr << "SST rollback failed on CPU "
+                              << request->sockets[i].address - MIN_CLIENT_ADDR
+                              << ": " << e.what() << '\n';
+                }
+                if (--request->outstanding == 0)
+                {
+                    finishApply(request);
+                }
+            });
+    }
+    if (request->outstanding == 0)
+    {
+        finishApply(request);
+    }
+}
+
+/**
+ * D-Bus method handler for ApplyOperatingConfig. Applies a config level, and
+ * optionally the SST-BF and SST-TF state, to several sockets concurrently.
+ * If any socket fails, the sockets which were already changed are rolled back.
+ *
+ * PECI is not waited on, so the method returns an ID right away, and the
+ * ApplyOperatingConfigComplete signal carries the same ID with the results.
+ *
+ * @param[in]   level       Config TDP level to apply.
+ * @param[in]   sockets     Indexes of the CPUs to apply it to.
+ * @param[in]   bfEnabled   1/0 to enable/disable SST-BF, -1 to leave as is.
+ * @param[in]   tfEnabled   1/0 to enable/disable SST-TF, -1 to leave as is.
+ *
+ * @return  ID of the request.
+ */
+static uint64_t applyOperatingConfig(uint32_t level,
+                                     const std::vector<uint32_t>& sockets,
+                                     int32_t bfEnabled, int32_t tfEnabled)
+{
+    static uint64_t nextId = 1;
+
+    if (hostState != HostState::postComplete || activeApply)
+    {
+        throw sdbusplus::xyz::openbmc_project::Common::Error::Unavailable();
+    }
+    if (sockets.empty() || bfEnabled < -1 || bfEnabled > 1 || tfEnabled < -1 ||
+        tfEnabled > 1)
+    {
+        throw sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument();
+    }
+
+    auto request = std::make_shared<ApplyRequest>();
+    request->id = nextId++;
+    request->level = level;
+    if (bfEnabled >= 0)
+    {
+        request->bfEnabled = bfEnabled == 1;
+    }
+    if (tfEnabled >= 0)
+    {
+        request->tfEnabled = tfEnabled == 1;
+    }
+
+    for (uint32_t index : sockets)
+    {
+        auto cpu = std::ranges::find_if(publishedCPUs, [index](auto& c) {
+            return c->address() == index + MIN_CLIENT_ADDR;
+        });
+        bool duplicate = std::ranges::any_of(
+            request->sockets, [index](const SocketApply& socket) {
+                return socket.address == index + MIN_CLIENT_ADDR;
+            });
+        if (cpu == publishedCPUs.end() || duplicate ||
+            !(*cpu)->hasLevel(level))
+        {
+            throw sdbusplus::xyz::openbmc_project::Common::Error::
+                InvalidArgument();
+        }
+        SocketApply socket{};
+        socket.address = (*cpu)->address();
+        socket.model = (*cpu)->model();
+        request->sockets.push_back(std::move(socket));
+    }
+    request->results.resize(request->sockets.size());
+
+    activeApply = request;
+    request->outstanding = request->sockets.size();
+    for (size_t i = 0; i < request->sockets.size(); i++)
+    {
+        peci::getWorker().post(
+            [socket = request->sockets[i], level, bf = request->bfEnabled,
+             tf = request->tfEnabled]() {
+                return applyToSocket(socket, level, bf, tf);
+            },
+            [request, i](std::exception_ptr err, SocketApply result) {
+                if (err)
+                {
+                    // Only happens if the worker was cancelled, because the
+                    // host powered off.
+                    request->sockets[i].error = "Cancelled";
+                }
+                else
+                {
+                    request->sockets[i] = std::move(result);
+                }
+                if (--request->outstanding == 0)
+                {
+                    applyDone(request);
+                }
+            });
+    }
+    return request->id;
+}
+
+void init(sdbusplus::asio::object_server& objServer)
 {
     addHostStateCallback(hostStateHandler);
+
+    speedSelectIface =
+        objServer.add_interface(cpuInfoPath, speedSelectInterface);
+    speedSelectIface->register_method(
+        "ApplyOperatingConfig",
+        [](uint32_t level, const std::vector<uint32_t>& sockets,
+           int32_t bfEnabled, int32_t tfEnabled) {
+            return applyOperatingConfig(level, sockets, bfEnabled, tfEnabled);
+        });
+    speedSelectIface->register_signal<
+        uint64_t, bool,
+        std::vector<std::tuple<uint32_t, std::string, std::string, uint64_t>>>(
+        applyCompleteSignal);
+    speedSelectIface->initialize();
 }
 
 } // namespace sst
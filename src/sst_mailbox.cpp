@@ -13,86 +13,108 @@
 // limitations under the License.
 
 #include "cpuinfo_utils.hpp"
+#include "peci_instrumentation.hpp"
 #include "speed_select.hpp"
+#include "wake_on_peci.hpp"
 
+#include <boost/container/flat_map.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
 
 namespace cpu_info
 {
 namespace sst
 {
 
+// Bounds on OS Mailbox polling, set by the sst-mailbox-* meson options.
+#ifndef SST_MAILBOX_MAX_BACKOFF_US
+#define SST_MAILBOX_MAX_BACKOFF_US 5000
+#endif
+#ifndef SST_MAILBOX_DEADLINE_MS
+#define SST_MAILBOX_DEADLINE_MS 100
+#endif
+
+/**
+ * How to wait for the OS Mailbox RUN_BUSY bit to clear. Every poll is a full
+ * PECI transaction, so rather than spinning, back off between polls. Mailbox
+ * commands only ever run on the PECI worker, so sleeping there doesn't hold up
+ * anything else.
+ */
+struct MailboxPollPolicy
+{
+    /** Delay before the first poll. Most commands complete very quickly. */
+    std::chrono::microseconds initialDelay{0};
+    /** Delay after the first poll which found the mailbox busy. */
+    std::chrono::microseconds firstBackoff{50};
+    /** Factor by which the delay grows after each busy poll. */
+    unsigned int backoffFactor = 2;
+    /** Upper bound for the delay between two polls. */
+    std::chrono::microseconds maxBackoff{SST_MAILBOX_MAX_BACKOFF_US};
+    /** Give up if the mailbox is still busy after this long. */
+    std::chrono::microseconds deadline{
+        std::chrono::milliseconds(SST_MAILBOX_DEADLINE_MS)};
+};
+
+static constexpr MailboxPollPolicy defaultMailboxPollPolicy{};
+
 /**
  * Convenience RAII object for Wake-On-PECI (WOP) management, since PECI Config
  * Local accesses to the OS Mailbox require the package to pop up to PC2. Also
  * provides PCode OS Mailbox routine.
  *
- * Since multiple applications may be modifying WOP, we'll use this algorithm:
- * Whenever a PECI command fails with associated error code, set WOP bit and
- * retry command. Upon manager destruction, clear WOP bit only if we previously
- * set it.
+ * Whenever a PECI command fails with associated error code, take a WOP lease
+ * and retry command. If another manager for the same CPU already holds the
+ * lease, this one joins it, so that a burst of operations on a CPU shares one
+ * wake/sleep cycle. See WakeOnPECILease.
  */
 struct PECIManager
 {
     uint8_t peciAddress;
-    bool peciWoken;
     CPUModel cpuModel;
     uint8_t mbBus;
     WakePolicy wakePolicy;
+    MailboxPollPolicy pollPolicy = defaultMailboxPollPolicy;
+    WakeOnPECILease wakeLease;
 
-    PECIManager(uint8_t address, CPUModel model, WakePolicy wakePolicy_) :
-        peciAddress(address), peciWoken(false), cpuModel(model),
-        wakePolicy(wakePolicy_)
+    /** Cached mailbox response, see cachedMailboxCmd. */
+    struct MailboxResponse
     {
-        mbBus = (model == iceLake) ? mbBusIceLake : mbBusOther;
-    }
+        uint32_t data;
+        uint8_t status;
+        /** PECI transactions it took to get this response. */
+        unsigned int transactions;
+    };
+    boost::container::flat_map<std::tuple<uint8_t, uint8_t, uint32_t>,
+                               MailboxResponse>
+        responseCache;
+    /** PECI transactions issued by this manager. */
+    unsigned int transactions = 0;
+    /** PECI transactions avoided by answering from responseCache. */
+    unsigned int transactionsSaved = 0;
 
-    ~PECIManager()
+    PECIManager(uint8_t address, CPUModel model, WakePolicy wakePolicy_) :
+        peciAddress(address), cpuModel(model), wakePolicy(wakePolicy_),
+        wakeLease(address)
     {
-        // If we're being destroyed due to a PECIError, try to clear the mode
-        // bit, but catch and ignore any duplicate error it might raise to
-        // prevent termination.
-        try
+        mbBus = (model == iceLake) ? mbBusIceLake : mbBusOther;
+        if (wakePolicy == wakeAllowed)
         {
-            if (peciWoken)
-            {
-                setWakeOnPECI(false);
-            }
+            wakeLease.join();
         }
-        catch (const PECIError& err)
-        {}
     }
 
-    static bool isSleeping(EPECIStatus libStatus, uint8_t completionCode)
-    {
-        // PECI completion code defined in peci-ioctl.h which is not available
-        // for us to include.
-        constexpr int PECI_DEV_CC_UNAVAIL_RESOURCE = 0x82;
-        // Observed library returning DRIVER_ERR for reads and TIMEOUT for
-        // writes while PECI is sleeping. Either way, the completion code from
-        // PECI client should be reliable indicator of need to set WOP.
-        return libStatus != PECI_CC_SUCCESS &&
-               completionCode == PECI_DEV_CC_UNAVAIL_RESOURCE;
-    }
-
-    /**
-     * Send a single PECI PCS write to modify the Wake-On-PECI mode bit
-     */
-    void setWakeOnPECI(bool enable)
+    ~PECIManager()
     {
-        uint8_t completionCode;
-        EPECIStatus libStatus =
-            peci_WrPkgConfig(peciAddress, 5, enable ? 1 : 0, 0,
-                             sizeof(uint32_t), &completionCode);
-        if (!checkPECIStatus(libStatus, completionCode))
-        {
-            throw PECIError("Failed to set Wake-On-PECI mode bit");
-        }
-
-        if (enable)
-        {
-            peciWoken = true;
-        }
+        DEBUG_PRINT << "PECIManager " << static_cast<int>(peciAddress)
+                    << ": sent " << transactions << " PECI transactions, saved "
+                    << transactionsSaved << " with mailbox cache\n";
     }
 
     // PCode OS Mailbox interface register locations
@@ -105,6 +127,19 @@ struct PECIManager
     static constexpr int mbInterfaceReg = 0xA4;
     static constexpr int mbRegSize = sizeof(uint32_t);
 
+    /**
+     * An OS mailbox command is a sequence of several PECI transactions, which
+     * must not be interleaved with another command to the same CPU. Commands
+     * may be issued from several PECI worker threads, so serialize them per
+     * CPU.
+     */
+    static std::mutex& mailboxMutex(uint8_t address)
+    {
+        static std::array<std::mutex, MAX_CLIENT_ADDR - MIN_CLIENT_ADDR + 1>
+            mutexes;
+        return mutexes.at(address - MIN_CLIENT_ADDR);
+    }
+
     enum class MailboxStatus
     {
         NoError = 0x0,
@@ -125,15 +160,23 @@ struct PECIManager
         bool tryWaking = (wakePolicy == wakeAllowed);
         while (true)
         {
-            EPECIStatus libStatus = peci_WrEndPointPCIConfigLocal(
+            EPECIStatus libStatus = peci::wrEndPointPCIConfigLocal(
                 peciAddress, mbSegment, mbBus, mbDevice, mbFunction, regAddress,
                 mbRegSize, data, &completionCode);
+            transactions++;
             if (tryWaking && isSleeping(libStatus, completionCode))
             {
-                setWakeOnPECI(true);
+                peci::recordRetry(peci::Retry::wakeOnPECI);
+                wakeLease.acquire();
+                transactions++;
                 tryWaking = false;
                 continue;
             }
+            else if (wakePolicy == dontWake &&
+                     isSleeping(libStatus, completionCode))
+            {
+                throw PECISleepingError("Failed to write mailbox reg");
+            }
             else if (!checkPECIStatus(libStatus, completionCode))
             {
                 throw PECIError("Failed to write mailbox reg");
@@ -157,16 +200,23 @@ struct PECIManager
         bool tryWaking = (wakePolicy == wakeAllowed);
         while (true)
         {
-            EPECIStatus libStatus = peci_RdEndPointConfigPciLocal(
+            EPECIStatus libStatus = peci::rdEndPointConfigPciLocal(
                 peciAddress, mbSegment, mbBus, mbDevice, mbFunction, regAddress,
                 mbRegSize, reinterpret_cast<uint8_t*>(&outputData),
                 &completionCode);
+            transactions++;
             if (tryWaking && isSleeping(libStatus, completionCode))
             {
-                setWakeOnPECI(true);
+                peci::recordRetry(peci::Retry::wakeOnPECI);
+                wakeLease.acquire();
+                transactions++;
                 tryWaking = false;
                 continue;
             }
+            if (wakePolicy == dontWake && isSleeping(libStatus, completionCode))
+            {
+                throw PECISleepingError("Failed to read mailbox reg");
+            }
             if (!checkPECIStatus(libStatus, completionCode))
             {
                 throw PECIError("Failed to read mailbox reg");
@@ -176,6 +226,46 @@ struct PECIManager
         return outputData;
     }
 
+    static constexpr uint32_t mbBusyBit = bit(31);
+
+    /**
+     * Poll the interface register until the RUN_BUSY bit is clear, following
+     * pollPolicy.
+     *
+     * @param[in,out]   polls   Incremented for every read of the register.
+     *
+     * @return  Last value read from the interface register, or nullopt if the
+     *          mailbox was still busy at the deadline.
+     */
+    std::optional<uint32_t> waitWhileBusy(unsigned int& polls)
+    {
+        auto deadline = std::chrono::steady_clock::now() + pollPolicy.deadline;
+        std::chrono::microseconds delay = pollPolicy.initialDelay;
+        bool firstPoll = true;
+        while (true)
+        {
+            if (delay.count() > 0)
+            {
+                std::this_thread::sleep_for(delay);
+            }
+            uint32_t interfaceReg = rdMailboxReg(mbInterfaceReg);
+            polls++;
+            if ((interfaceReg & mbBusyBit) == 0)
+            {
+                return interfaceReg;
+            }
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return std::nullopt;
+            }
+            peci::recordRetry(peci::Retry::mailboxBusy);
+            delay = firstPoll ? pollPolicy.firstBackoff
+                              : std::min(delay * pollPolicy.backoffFactor,
+                                         pollPolicy.maxBackoff);
+            firstPoll = false;
+        }
+    }
+
     /**
      * Send command on PCode OS Mailbox interface.
      *
@@ -195,18 +285,12 @@ struct PECIManager
                                   uint32_t inputData = 0,
                                   MailboxStatus* responseCode = nullptr)
     {
-        // The simple mailbox algorithm just says to wait until the busy bit
-        // is clear, but we'll give up after 10 tries. It's arbitrary but that's
-        // quite long wall clock time.
-        constexpr int mbRetries = 10;
-        constexpr uint32_t mbBusyBit = bit(31);
+        std::lock_guard lock(mailboxMutex(peciAddress));
+        auto start = std::chrono::steady_clock::now();
 
         // Wait until RUN_BUSY == 0
-        int attempts = mbRetries;
-        while ((rdMailboxReg(mbInterfaceReg) & mbBusyBit) != 0 &&
-               --attempts > 0)
-            ;
-        if (attempts == 0)
+        unsigned int polls = 0;
+        if (!waitWhileBusy(polls))
         {
             throw PECIError("OS Mailbox failed to become free");
         }
@@ -221,15 +305,16 @@ struct PECIManager
         wrMailboxReg(mbInterfaceReg, interfaceReg);
 
         // Wait until RUN_BUSY == 0
-        attempts = mbRetries;
-        do
-        {
-            interfaceReg = rdMailboxReg(mbInterfaceReg);
-        } while ((interfaceReg & mbBusyBit) != 0 && --attempts > 0);
-        if (attempts == 0)
+        std::optional<uint32_t> response = waitWhileBusy(polls);
+        peci::recordMailboxCommand(
+            subCommand, polls,
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start));
+        if (!response)
         {
             throw PECIError("OS Mailbox failed to return");
         }
+        interfaceReg = *response;
 
         // Read command return status or error code from interface register
         auto status = static_cast<MailboxStatus>(interfaceReg & 0xFF);
@@ -246,14 +331,79 @@ struct PECIManager
         // Read command return data from the data register
         return rdMailboxReg(mbDataReg);
     }
+
+    /**
+     * Send a "getter" command on the PCode OS Mailbox interface, or return the
+     * response to an identical earlier command from this manager. Within the
+     * lifetime of one SST instance the configuration only changes through our
+     * own "setter" commands, which clear the cache (see uncachedMailboxCmd).
+     *
+     * Parameters and return value are the same as sendPECIOSMailboxCmd.
+     */
+    uint32_t cachedMailboxCmd(uint8_t command, uint8_t subCommand,
+                              uint32_t inputData = 0,
+                              MailboxStatus* responseCode = nullptr)
+    {
+        auto key = std::make_tuple(command, subCommand, inputData);
+        auto it = responseCache.find(key);
+        if (it == responseCache.end())
+        {
+            unsigned int transactionsBefore = transactions;
+            MailboxStatus status;
+            // Always ask for the status so that error responses are cached
+            // too, and apply the caller's error policy below.
+            uint32_t data =
+                sendPECIOSMailboxCmd(command, subCommand, inputData, &status);
+            it = responseCache
+                     .emplace(key,
+                              MailboxResponse{
+                                  data, static_cast<uint8_t>(status),
+                                  transactions - transactionsBefore})
+                     .first;
+        }
+        else
+        {
+            transactionsSaved += it->second.transactions;
+        }
+
+        auto status = static_cast<MailboxStatus>(it->second.status);
+        if (responseCode != nullptr)
+        {
+            *responseCode = status;
+        }
+        else if (status != MailboxStatus::NoError)
+        {
+            throw PECIError(std::string("OS Mailbox returned with error: ") +
+                            std::to_string(static_cast<int>(status)));
+        }
+        return it->second.data;
+    }
+
+    /**
+     * Send a "setter" command on the PCode OS Mailbox interface. Since it may
+     * change the configuration, all cached responses are dropped.
+     *
+     * Parameters and return value are the same as sendPECIOSMailboxCmd.
+     */
+    uint32_t uncachedMailboxCmd(uint8_t command, uint8_t subCommand,
+                                uint32_t inputData = 0,
+                                MailboxStatus* responseCode = nullptr)
+    {
+        responseCache.clear();
+        return sendPECIOSMailboxCmd(command, subCommand, inputData,
+                                    responseCode);
+    }
 };
 
 /**
  * Base class for set of PECI OS Mailbox commands.
  * Constructing it runs the command and stores the value for use by derived
  * class accessor methods.
+ *
+ * Commands which only read state are cacheable, and may be answered from the
+ * PECIManager's response cache. Commands which change state must not be.
  */
-template <uint8_t subcommand>
+template <uint8_t subcommand, bool cacheable = true>
 struct OsMailboxCommand
 {
     enum ErrorPolicy
@@ -284,7 +434,14 @@ struct OsMailboxCommand
         uint32_t param = (static_cast<uint32_t>(param4) << 24) |
                          (static_cast<uint32_t>(param3) << 16) |
                          (static_cast<uint32_t>(param2) << 8) | param1;
-        value = pm.sendPECIOSMailboxCmd(0x7F, subcommand, param, callStatus);
+        if constexpr (cacheable)
+        {
+            value = pm.cachedMailboxCmd(0x7F, subcommand, param, callStatus);
+        }
+        else
+        {
+            value = pm.uncachedMailboxCmd(0x7F, subcommand, param, callStatus);
+        }
     }
 
     /** Return whether the mailbox status indicated success or not. */
@@ -327,7 +484,7 @@ struct GetConfigTdpControl : OsMailboxCommand<0x1>
     FIELD(bool, factSupport, 0, 0);
 };
 
-struct SetConfigTdpControl : OsMailboxCommand<0x2>
+struct SetConfigTdpControl : OsMailboxCommand<0x2, false>
 {
     using OsMailboxCommand::OsMailboxCommand;
 };
@@ -350,7 +507,7 @@ struct GetTurboLimitRatios : OsMailboxCommand<0x7>
     using OsMailboxCommand::OsMailboxCommand;
 };
 
-struct SetLevel : OsMailboxCommand<0x8>
+struct SetLevel : OsMailboxCommand<0x8, false>
 {
     using OsMailboxCommand::OsMailboxCommand;
 };
@@ -398,6 +555,56 @@ class SSTMailbox : public SSTInterface
 
     static constexpr int mhzPerRatio = 100;
 
+    /** Upper bound on the 32-bit words read for a core mask, i.e. 512 cores. */
+    static constexpr unsigned int maxCoreMaskWords = 16;
+
+    /**
+     * Number of 32-bit words in a core mask. Core masks have one bit per
+     * logical core, so this follows from the core count in the package's
+     * MSR_CORE_THREAD_COUNT, which is only read once.
+     */
+    unsigned int coreMaskWords()
+    {
+        constexpr uint16_t coreThreadCountMsr = 0x35;
+        uint64_t coreThreadCount =
+            packageRegisters.get(coreThreadCountMsr, [this]() {
+                uint64_t value;
+                uint8_t cc;
+                EPECIStatus status =
+                    peci::rdIAMSR(static_cast<uint8_t>(address), 0,
+                                  coreThreadCountMsr, &value, &cc);
+                if (!checkPECIStatus(status, cc))
+                {
+                    throw PECIError("Failed to read core count MSR");
+                }
+                return value;
+            });
+        unsigned int cores = (coreThreadCount >> 16) & 0xFFFF;
+        return std::clamp((cores + 31) / 32, 1U, maxCoreMaskWords);
+    }
+
+    /**
+     * Read a core mask, one 32-bit word at a time, for as many words as the
+     * package has cores.
+     *
+     * @tparam      Command Mailbox command returning one word of the mask.
+     * @tparam      field   Accessor for the mask word in the response.
+     * @param[in]   level   SST-PP level.
+     *
+     * @return  List of core indices.
+     */
+    template <typename Command, uint32_t (Command::*field)() const>
+    std::vector<unsigned int> readCoreMask(unsigned int level)
+    {
+        std::vector<uint32_t> words(coreMaskWords());
+        for (unsigned int word = 0; word < words.size(); word++)
+        {
+            words[word] = (Command(pm, static_cast<uint8_t>(level),
+                                   static_cast<uint8_t>(word)).*field)();
+        }
+        return convertMaskToList(words);
+    }
+
   public:
     SSTMailbox(uint8_t _address, CPUModel _model, WakePolicy wakePolicy) :
         address(_address), model(_model),
@@ -434,6 +641,10 @@ class SSTMailbox : public SSTInterface
     {
         return GetLevelsInfo(pm).enabled();
     }
+    bool configLocked() override
+    {
+        return GetLevelsInfo(pm).lock();
+    }
 
     bool levelSupported(unsigned int level) override
     {
@@ -472,26 +683,25 @@ class SSTMailbox : public SSTInterface
     }
     std::vector<unsigned int> enabledCoreList(unsigned int level) override
     {
-        uint64_t coreMaskLo =
-            GetCoreMask(pm, static_cast<uint8_t>(level), 0).coresMask();
-        uint64_t coreMaskHi =
-            GetCoreMask(pm, static_cast<uint8_t>(level), 1).coresMask();
-        std::bitset<64> coreMask = (coreMaskHi << 32 | coreMaskLo);
-        return convertMaskToList(coreMask);
+        return readCoreMask<GetCoreMask, &GetCoreMask::coresMask>(level);
     }
     std::vector<TurboEntry> sseTurboProfile(unsigned int level) override
     {
         // Read the Turbo Ratio Limit Cores MSR which is used to generate the
         // Turbo Profile for each profile. This is a package scope MSR, so just
-        // read thread 0.
-        uint64_t trlCores;
-        uint8_t cc;
-        EPECIStatus status = peci_RdIAMSR(static_cast<uint8_t>(address), 0,
-                                          0x1AE, &trlCores, &cc);
-        if (!checkPECIStatus(status, cc))
-        {
-            throw PECIError("Failed to read TRL MSR");
-        }
+        // read thread 0, and only once for all levels.
+        constexpr uint16_t trlCoresMsr = 0x1AE;
+        uint64_t trlCores = packageRegisters.get(trlCoresMsr, [this]() {
+            uint64_t value;
+            uint8_t cc;
+            EPECIStatus status = peci::rdIAMSR(static_cast<uint8_t>(address), 0,
+                                               trlCoresMsr, &value, &cc);
+            if (!checkPECIStatus(status, cc))
+            {
+                throw PECIError("Failed to read TRL MSR");
+            }
+            return value;
+        });
 
         std::vector<TurboEntry> turboSpeeds;
         uint64_t limitRatioLo =
@@ -530,14 +740,8 @@ class SSTMailbox : public SSTInterface
     std::vector<unsigned int>
         bfHighPriorityCoreList(unsigned int level) override
     {
-        uint64_t coreMaskLo =
-            PbfGetCoreMaskInfo(pm, static_cast<uint8_t>(level), 0)
-                .p1HiCoreMask();
-        uint64_t coreMaskHi =
-            PbfGetCoreMaskInfo(pm, static_cast<uint8_t>(level), 1)
-                .p1HiCoreMask();
-        std::bitset<64> hiFreqCoreList = (coreMaskHi << 32) | coreMaskLo;
-        return convertMaskToList(hiFreqCoreList);
+        return readCoreMask<PbfGetCoreMaskInfo,
+                            &PbfGetCoreMaskInfo::p1HiCoreMask>(level);
     }
     unsigned int bfHighPriorityFreq(unsigned int level) override
     {
@@ -550,24 +754,20 @@ class SSTMailbox : public SSTInterface
                mhzPerRatio;
     }
 
-    void setBfEnabled(bool enable) override
-    {
-        GetConfigTdpControl getTDPControl(pm);
-        bool tfEnabled = false;
-        uint8_t param = (enable ? bit(1) : 0) | (tfEnabled ? bit(0) : 0);
-        SetConfigTdpControl(pm, 0, 0, param);
-    }
-    void setTfEnabled(bool enable) override
+    void setBfTfEnabled(bool bfEnable, bool tfEnable) override
     {
-        // TODO: use cached BF value
-        bool bfEnabled = false;
-        uint8_t param = (bfEnabled ? bit(1) : 0) | (enable ? bit(0) : 0);
+        uint8_t param = (bfEnable ? bit(1) : 0) | (tfEnable ? bit(0) : 0);
         SetConfigTdpControl(pm, 0, 0, param);
     }
     void setCurrentLevel(unsigned int level) override
     {
         SetLevel(pm, static_cast<uint8_t>(level));
     }
+
+    void idle() override
+    {
+        pm.wakeLease.release();
+    }
 };
 
 static std::unique_ptr<SSTInterface>
@@ -0,0 +1,423 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cpuinfo_utils.hpp"
+#include "peci_instrumentation.hpp"
+#include "speed_select.hpp"
+
+#include <boost/container/flat_map.hpp>
+
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace cpu_info
+{
+namespace sst
+{
+
+/**
+ * Extract the bits hibit:lobit of a register value.
+ */
+static constexpr uint64_t field(uint64_t value, unsigned int hibit,
+                                unsigned int lobit)
+{
+    uint64_t width = hibit - lobit + 1;
+    return (value >> lobit) & (width == 64 ? ~uint64_t{0} : bit(width) - 1);
+}
+
+/**
+ * Reads the TPMI (Topology Aware Register and PM Capsule Interface) MMIO space
+ * of one CPU over PECI. Registers are read a whole block at a time, with one
+ * 64-bit MMIO read per register and no handshake, and kept for the lifetime of
+ * the reader. Within one SSTInterface instance, every register is read at most
+ * once.
+ */
+class TPMIReader
+{
+  public:
+    explicit TPMIReader(uint8_t address) : address(address) {}
+
+    /**
+     * Return a register of a block, reading the whole block if it wasn't read
+     * yet.
+     *
+     * @param[in]   blockOffset Offset of the block in the TPMI BAR.
+     * @param[in]   blockSize   Number of 64-bit registers in the block.
+     * @param[in]   index       Index of the register in the block.
+     */
+    uint64_t get(uint64_t blockOffset, unsigned int blockSize,
+                 unsigned int index)
+    {
+        uint64_t offset = blockOffset + index * regSize;
+        auto it = registers.find(offset);
+        if (it != registers.end())
+        {
+            return it->second;
+        }
+        for (unsigned int i = 0; i < blockSize; i++)
+        {
+            uint64_t regOffset = blockOffset + i * regSize;
+            if (!registers.contains(regOffset))
+            {
+                registers.emplace(regOffset, read(regOffset));
+            }
+        }
+        return registers.at(offset);
+    }
+
+    static constexpr unsigned int regSize = sizeof(uint64_t);
+
+  private:
+    // OOBMSM PCI function which exposes TPMI in its BAR
+    static constexpr uint8_t oobmsmSegment = 0;
+    static constexpr uint8_t oobmsmBus = 0;
+    static constexpr uint8_t oobmsmDevice = 3;
+    static constexpr uint8_t oobmsmFunction = 1;
+    static constexpr uint8_t tpmiBar = 0;
+    static constexpr uint8_t mmioAddrType64 = 0x6;
+
+    uint8_t address;
+    boost::container::flat_map<uint64_t, uint64_t> registers;
+
+    uint64_t read(uint64_t offset)
+    {
+        uint64_t value = 0;
+        uint8_t cc = 0;
+        EPECIStatus status = peci::rdEndPointConfigMmio(
+            address, oobmsmSegment, oobmsmBus, oobmsmDevice, oobmsmFunction,
+            tpmiBar, mmioAddrType64, offset, regSize,
+            reinterpret_cast<uint8_t*>(&value), &cc);
+        if (isSleeping(status, cc))
+        {
+            // TPMI reads never wake the package.
+            throw PECISleepingError("Failed to read TPMI register");
+        }
+        if (!checkPECIStatus(status, cc))
+        {
+            throw PECIError("Failed to read TPMI register");
+        }
+        return value;
+    }
+};
+
+/**
+ * Implementation of SSTInterface based on the TPMI SST registers of Granite
+ * Rapids and Sierra Forest processors.
+ *
+ * The CPU has one SST instance per power domain (compute die), each with its
+ * own SST-PP level info. Package values are taken from the first power
+ * domain, while the core lists are merged from all of them. Core indices are
+ * the bit index in the domain's core mask, plus 64 for each domain before it.
+ *
+ * Control is not supported: the configuration is only discovered.
+ */
+class SSTTPMI : public SSTInterface
+{
+  private:
+    // PM Feature Structure (PFS) at the start of the TPMI BAR, one 64-bit
+    // entry per feature.
+    static constexpr unsigned int maxPfsEntries = 32;
+    static constexpr uint64_t tpmiIdInvalid = 0xFF;
+    static constexpr uint64_t tpmiIdSST = 0x5;
+
+    // SST header, at the start of each SST instance
+    static constexpr uint64_t sstCapPP = bit(1);
+
+    // SST-PP registers, at the PP offset of the SST instance
+    static constexpr unsigned int ppHeader = 0;
+    static constexpr unsigned int ppFeatureOffsets = 1;
+    static constexpr unsigned int ppLevelOffsets = 2;
+    static constexpr unsigned int ppStatus = 4;
+    static constexpr unsigned int ppBlockSize = 5;
+
+    // Per-level SST-PP info registers
+    static constexpr unsigned int ppInfoFeatures = 0;
+    static constexpr unsigned int ppInfoTdp = 1;
+    static constexpr unsigned int ppInfoCoreMask = 2;
+    static constexpr unsigned int ppInfoRatios = 4;
+    static constexpr unsigned int ppInfoTurboRatios = 10;
+    static constexpr unsigned int ppInfoTurboCores = 11;
+    static constexpr unsigned int ppInfoSize = 12;
+
+    // Per-level SST-BF info registers
+    static constexpr unsigned int bfInfoRatios = 0;
+    static constexpr unsigned int bfInfoCoreMask = 1;
+    static constexpr unsigned int bfInfoSize = 2;
+
+    /** PP_LEVEL_OFFSETS only has room for this many levels. */
+    static constexpr unsigned int maxLevels = 5;
+    static constexpr unsigned int coresPerDomain = 64;
+    static constexpr int mhzPerRatio = 100;
+
+    TPMIReader tpmi;
+    /** TPMI BAR offset of the SST-PP registers of each power domain. */
+    std::vector<uint64_t> domains;
+    bool domainsFound = false;
+
+    /**
+     * Locate the SST instance of each power domain through the PFS. Domains
+     * which aren't present read as all ones, and are skipped.
+     */
+    void findDomains()
+    {
+        if (domainsFound)
+        {
+            return;
+        }
+        domainsFound = true;
+
+        for (unsigned int i = 0; i < maxPfsEntries; i++)
+        {
+            uint64_t entry = tpmi.get(i * TPMIReader::regSize, 1, 0);
+            uint64_t tpmiId = field(entry, 7, 0);
+            if (tpmiId == tpmiIdInvalid)
+            {
+                break;
+            }
+            if (tpmiId != tpmiIdSST)
+            {
+                continue;
+            }
+
+            uint64_t numEntries = field(entry, 15, 8);
+            uint64_t entrySize = field(entry, 31, 16) * sizeof(uint32_t);
+            uint64_t capOffset = field(entry, 47, 32) * 1024;
+            for (uint64_t domain = 0; domain < numEntries; domain++)
+            {
+                uint64_t instance = capOffset + domain * entrySize;
+                uint64_t header = tpmi.get(instance, 1, 0);
+                if (header == ~uint64_t{0} ||
+                    (field(header, 15, 8) & sstCapPP) == 0)
+                {
+                    continue;
+                }
+                domains.push_back(instance +
+                                  field(header, 31, 24) * TPMIReader::regSize);
+            }
+            break;
+        }
+    }
+
+    uint64_t ppRegister(size_t domain, unsigned int index)
+    {
+        return tpmi.get(domains.at(domain), ppBlockSize, index);
+    }
+
+    /** Mask of the SST-PP levels enabled in a power domain. */
+    uint64_t levelMask(size_t domain)
+    {
+        return field(ppRegister(domain, ppHeader), 15, 8) &
+               (bit(maxLevels) - 1);
+    }
+
+    /** TPMI BAR offset of the registers of one level. */
+    uint64_t levelOffset(size_t domain, unsigned int level)
+    {
+        uint64_t offsets = ppRegister(domain, ppLevelOffsets);
+        return domains.at(domain) +
+               field(offsets, level * 8 + 7, level * 8) * TPMIReader::regSize;
+    }
+
+    uint64_t ppInfo(size_t domain, unsigned int level, unsigned int index)
+    {
+        uint64_t offset =
+            levelOffset(domain, level) +
+            field(ppRegister(domain, ppFeatureOffsets), 7, 0) *
+                TPMIReader::regSize;
+        return tpmi.get(offset, ppInfoSize, index);
+    }
+
+    uint64_t bfInfo(size_t domain, unsigned int level, unsigned int index)
+    {
+        uint64_t offset =
+            levelOffset(domain, level) +
+            field(ppRegister(domain, ppFeatureOffsets), 15, 8) *
+                TPMIReader::regSize;
+        return tpmi.get(offset, bfInfoSize, index);
+    }
+
+    /**
+     * Merge a per-domain core mask register of every power domain into one
+     * list of core indices.
+     */
+    template <typename ReadMask>
+    std::vector<unsigned int> coreList(ReadMask&& readMask)
+    {
+        static_assert(coresPerDomain == std::numeric_limits<uint64_t>::digits);
+        std::vector<uint64_t> masks;
+        masks.reserve(domains.size());
+        for (size_t domain = 0; domain < domains.size(); domain++)
+        {
+            masks.push_back(readMask(domain));
+        }
+        return convertMaskToList(masks);
+    }
+
+  public:
+    SSTTPMI(uint8_t address) : tpmi(address) {}
+
+    bool ready() override
+    {
+        // TPMI is set up by the BIOS, so there may not be any SST instances
+        // yet early in POST.
+        findDomains();
+        return !domains.empty();
+    }
+
+    bool supportsControl() override
+    {
+        return false;
+    }
+
+    unsigned int currentLevel() override
+    {
+        return field(ppRegister(0, ppStatus), 2, 0);
+    }
+    unsigned int maxLevel() override
+    {
+        uint64_t levels = levelMask(0);
+        return levels == 0 ? 0 : std::bit_width(levels) - 1;
+    }
+    bool ppEnabled() override
+    {
+        return levelMask(0) != 0;
+    }
+
+    bool levelSupported(unsigned int level) override
+    {
+        if (level >= maxLevels)
+        {
+            return false;
+        }
+        for (size_t domain = 0; domain < domains.size(); domain++)
+        {
+            if ((levelMask(domain) & bit(level)) == 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool bfSupported(unsigned int level) override
+    {
+        return ppInfo(0, level, ppInfoFeatures) & bit(0);
+    }
+    bool tfSupported(unsigned int level) override
+    {
+        return ppInfo(0, level, ppInfoFeatures) & bit(1);
+    }
+    bool bfEnabled(unsigned int /* level */) override
+    {
+        return ppRegister(0, ppStatus) & bit(8);
+    }
+    bool tfEnabled(unsigned int /* level */) override
+    {
+        return ppRegister(0, ppStatus) & bit(9);
+    }
+    unsigned int tdp(unsigned int level) override
+    {
+        return field(ppInfo(0, level, ppInfoTdp), 14, 0);
+    }
+    unsigned int coreCount(unsigned int level) override
+    {
+        return enabledCoreList(level).size();
+    }
+    std::vector<unsigned int> enabledCoreList(unsigned int level) override
+    {
+        return coreList([this, level](size_t domain) {
+            return ppInfo(domain, level, ppInfoCoreMask);
+        });
+    }
+    std::vector<TurboEntry> sseTurboProfile(unsigned int level) override
+    {
+        uint64_t limitRatios = ppInfo(0, level, ppInfoTurboRatios);
+        uint64_t trlCores = ppInfo(0, level, ppInfoTurboCores);
+
+        std::vector<TurboEntry> turboSpeeds;
+        constexpr int maxTFBuckets = 8;
+        for (int i = 0; i < maxTFBuckets; ++i)
+        {
+            size_t bucketCount = trlCores & 0xFF;
+            int bucketSpeed = limitRatios & 0xFF;
+            if (bucketCount != 0 && bucketSpeed != 0)
+            {
+                turboSpeeds.push_back({bucketSpeed * mhzPerRatio, bucketCount});
+            }
+
+            trlCores >>= 8;
+            limitRatios >>= 8;
+        }
+        return turboSpeeds;
+    }
+    unsigned int p1Freq(unsigned int level) override
+    {
+        return field(ppInfo(0, level, ppInfoRatios), 15, 8) * mhzPerRatio;
+    }
+    unsigned int p0Freq(unsigned int level) override
+    {
+        return field(ppInfo(0, level, ppInfoRatios), 7, 0) * mhzPerRatio;
+    }
+    unsigned int prochotTemp(unsigned int level) override
+    {
+        return field(ppInfo(0, level, ppInfoTdp), 22, 15);
+    }
+    std::vector<unsigned int>
+        bfHighPriorityCoreList(unsigned int level) override
+    {
+        return coreList([this, level](size_t domain) {
+            return bfInfo(domain, level, bfInfoCoreMask);
+        });
+    }
+    unsigned int bfHighPriorityFreq(unsigned int level) override
+    {
+        return field(bfInfo(0, level, bfInfoRatios), 7, 0) * mhzPerRatio;
+    }
+    unsigned int bfLowPriorityFreq(unsigned int level) override
+    {
+        return field(bfInfo(0, level, bfInfoRatios), 15, 8) * mhzPerRatio;
+    }
+
+    void setBfTfEnabled(bool /* bfEnable */, bool /* tfEnable */) override
+    {
+        throw PECIError("SST control not supported over TPMI");
+    }
+    void setCurrentLevel(unsigned int /* level */) override
+    {
+        throw PECIError("SST control not supported over TPMI");
+    }
+};
+
+static std::unique_ptr<SSTInterface>
+    createTPMI(uint8_t address, CPUModel model, WakePolicy /* wakePolicy */)
+{
+    DEBUG_PRINT << "createTPMI\n";
+    // TPMI is behind the OOBMSM, which stays available while the cores are
+    // in package C-states, so there is no need for Wake-On-PECI.
+    switch (model)
+    {
+        case graniteRapids:
+        case graniteRapidsD:
+        case sierraForest:
+            return std::make_unique<SSTTPMI>(address);
+        default:
+            return nullptr;
+    }
+}
+
+SSTProviderRegistration(createTPMI);
+
+} // namespace sst
+} // namespace cpu_info
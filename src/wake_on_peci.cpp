@@ -0,0 +1,198 @@
+// Copyright (c) 2026 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "wake_on_peci.hpp"
+
+#include "cpuinfo_utils.hpp"
+#include "peci_instrumentation.hpp"
+#include "peci_worker.hpp"
+#include "speed_select.hpp"
+
+#include <peci.h>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <array>
+#include <iostream>
+#include <mutex>
+#include <optional>
+
+namespace cpu_info
+{
+namespace sst
+{
+
+static constexpr size_t maxCPUs = MAX_CLIENT_ADDR - MIN_CLIENT_ADDR + 1;
+
+/** Shared lease state of one CPU. */
+struct LeaseState
+{
+    std::mutex mutex;
+    /** Number of WakeOnPECILease objects holding the lease. */
+    unsigned int holders = 0;
+    /** Whether we set the WOP bit and haven't cleared it yet. */
+    bool woken = false;
+    /**
+     * Incremented whenever the lease is taken, so that a release scheduled
+     * before that can tell it's stale.
+     */
+    uint64_t generation = 0;
+};
+
+static LeaseState& leaseState(uint8_t address)
+{
+    static std::array<LeaseState, maxCPUs> states;
+    return states.at(address - MIN_CLIENT_ADDR);
+}
+
+/**
+ * Send a single PECI PCS write to modify the Wake-On-PECI mode bit
+ */
+static void setWakeOnPECI(uint8_t address, bool enable)
+{
+    uint8_t completionCode;
+    EPECIStatus libStatus = peci::wrPkgConfig(
+        address, 5, enable ? 1 : 0, 0, sizeof(uint32_t), &completionCode);
+    if (!checkPECIStatus(libStatus, completionCode))
+    {
+        throw PECIError("Failed to set Wake-On-PECI mode bit");
+    }
+    peci::recordWakeOnPECI(enable);
+}
+
+/**
+ * Clear the WOP bit, unless the lease was taken again since the release was
+ * scheduled. Runs on the PECI worker.
+ */
+static void releaseNow(uint8_t address, uint64_t generation)
+{
+    LeaseState& state = leaseState(address);
+    std::lock_guard lock(state.mutex);
+    if (state.holders != 0 || !state.woken || state.generation != generation)
+    {
+        return;
+    }
+    // Even if clearing fails, the next command which finds the package asleep
+    // will take a new lease.
+    state.woken = false;
+    setWakeOnPECI(address, false);
+}
+
+/**
+ * Release the lease once the grace period expires. Timers are only touched on
+ * the io_context thread, so hop over there first.
+ */
+static void scheduleRelease(uint8_t address, uint64_t generation)
+{
+    boost::asio::post(dbus::getIOContext(), [address, generation]() {
+        static std::array<std::optional<boost::asio::steady_timer>, maxCPUs>
+            timers;
+        auto& timer = timers.at(address - MIN_CLIENT_ADDR);
+        if (!timer)
+        {
+            timer.emplace(dbus::getIOContext());
+        }
+
+        // Any earlier release still waiting is stale now, so replace it.
+        timer->expires_after(wakeLeaseGracePeriod);
+        timer->async_wait([address, generation](boost::system::error_code ec) {
+            if (ec)
+            {
+                return;
+            }
+            peci::getWorker().post(
+                [address, generation]() { releaseNow(address, generation); },
+                [address, generation](std::exception_ptr err) {
+                    try
+                    {
+                        if (err)
+                        {
+                            std::rethrow_exception(err);
+                        }
+                    }
+                    catch (const boost::system::system_error&)
+                    {
+                        // Cancelled because the host powered off, which
+                        // resets the WOP bit anyway.
+                        LeaseState& state = leaseState(address);
+                        std::lock_guard lock(state.mutex);
+                        if (state.generation == generation)
+                        {
+                            state.woken = false;
+                        }
+                    }
+                    catch (const std::exception& e)
+                    {
+                        std::cerr << "Failed to release Wake-On-PECI on CPU "
+                                  << address - MIN_CLIENT_ADDR << ": "
+                                  << e.what() << '\n';
+                    }
+                });
+        });
+    });
+}
+
+void WakeOnPECILease::acquire()
+{
+    LeaseState& state = leaseState(address);
+    std::lock_guard lock(state.mutex);
+
+    // The package was found asleep, so set the bit even if we think it's
+    // already set. Another application may have cleared it.
+    setWakeOnPECI(address, true);
+    state.woken = true;
+    state.generation++;
+    if (!held)
+    {
+        state.holders++;
+        held = true;
+    }
+}
+
+void WakeOnPECILease::join()
+{
+    LeaseState& state = leaseState(address);
+    std::lock_guard lock(state.mutex);
+    if (state.woken && !held)
+    {
+        state.generation++;
+        state.holders++;
+        held = true;
+    }
+}
+
+void WakeOnPECILease::release()
+{
+    if (!held)
+    {
+        return;
+    }
+
+    LeaseState& state = leaseState(address);
+    std::lock_guard lock(state.mutex);
+    held = false;
+    if (--state.holders == 0 && state.woken)
+    {
+        scheduleRelease(address, state.generation);
+    }
+}
+
+WakeOnPECILease::~WakeOnPECILease()
+{
+    release();
+}
+
+} // namespace sst
+} // namespace cpu_info